@@ -0,0 +1,131 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_BENCHMARK_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_BENCHMARK_OCTOBER_16_2019
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace cycfi { namespace elements { namespace benchmark
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // A minimal benchmark harness
+   //
+   // Each benchmark runs once to warm up, then for a number of samples of
+   // a fixed number of iterations each. We report the minimum, median and
+   // mean time per iteration. The minimum is the most repeatable figure,
+   // the median shows the typical case.
+   ////////////////////////////////////////////////////////////////////////////
+   struct result
+   {
+      std::string          name;
+      std::size_t          iterations;
+      std::size_t          samples;
+      double               min_ns;
+      double               median_ns;
+      double               mean_ns;
+   };
+
+   class suite
+   {
+   public:
+
+      explicit             suite(std::string filter = "")
+                            : _filter(std::move(filter))
+                           {}
+
+                           // Run f iterations times per sample. f is
+                           // called with the iteration index.
+                           template <typename F>
+      void                 run(
+                              std::string const& name
+                            , std::size_t iterations
+                            , F&& f
+                            , std::size_t samples = 10
+                           );
+
+      void                 write_json(std::FILE* out) const;
+
+   private:
+
+      std::string          _filter;
+      std::vector<result>  _results;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename F>
+   inline void suite::run(
+      std::string const& name
+    , std::size_t iterations
+    , F&& f
+    , std::size_t samples
+   )
+   {
+      if (!_filter.empty() && name.find(_filter) == std::string::npos)
+         return;
+
+      using clock = std::chrono::steady_clock;
+      using nanoseconds = std::chrono::duration<double, std::nano>;
+
+      f(std::size_t(0));
+
+      std::vector<double> times;
+      for (std::size_t s = 0; s != samples; ++s)
+      {
+         auto start = clock::now();
+         for (std::size_t i = 0; i != iterations; ++i)
+            f(i);
+         nanoseconds elapsed = clock::now() - start;
+         times.push_back(elapsed.count() / iterations);
+      }
+
+      std::sort(times.begin(), times.end());
+      double sum = 0;
+      for (auto t : times)
+         sum += t;
+
+      _results.push_back({
+         name, iterations, samples
+       , times.front(), times[times.size() / 2], sum / times.size()
+      });
+      std::fprintf(stderr, "%-40s %14.0f ns\n", name.c_str(), times.front());
+   }
+
+   inline void suite::write_json(std::FILE* out) const
+   {
+      std::fprintf(out, "{\n   \"benchmarks\": [");
+      for (std::size_t i = 0; i != _results.size(); ++i)
+      {
+         auto const& r = _results[i];
+         std::fprintf(out,
+            "%s\n      { \"name\": \"%s\", \"iterations\": %zu, \"samples\": %zu"
+            ", \"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f }"
+          , i ? "," : "", r.name.c_str(), r.iterations, r.samples
+          , r.min_ns, r.median_ns, r.mean_ns
+         );
+      }
+      std::fprintf(out, "\n   ]\n}\n");
+   }
+
+   // Keep the optimizer from discarding a result
+   template <typename T>
+   inline void do_not_optimize(T const& value)
+   {
+#if defined(__GNUC__)
+      asm volatile("" : : "r,m"(value) : "memory");
+#else
+      static volatile char const* sink;
+      sink = reinterpret_cast<char const volatile*>(&value);
+#endif
+   }
+}}}
+
+#endif
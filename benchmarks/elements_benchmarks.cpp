@@ -0,0 +1,447 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements.hpp>
+#include <elements/support/resource_paths.hpp>
+#include "benchmark.hpp"
+#include <boost/filesystem.hpp>
+#include <random>
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmarks for the library's hot paths. Results are written to stdout as
+// JSON, progress goes to stderr.
+//
+//    usage: elements_benchmarks [filter]
+//
+// Only the benchmarks whose name contains filter are run.
+///////////////////////////////////////////////////////////////////////////////
+using namespace cycfi::elements;
+using benchmark::suite;
+using benchmark::do_not_optimize;
+
+namespace fs = boost::filesystem;
+
+// A scratch surface to measure and draw on
+struct scratch
+{
+   scratch(view& v, point size = { 1, 1 })
+    : pm(size), pm_ctx(pm), cnv(*pm_ctx.context()), view_(v)
+   {}
+
+   context make_context(element& e, rect bounds)
+   {
+      return context{ view_, cnv, &e, bounds };
+   }
+
+   pixmap         pm;
+   pixmap_context pm_ctx;
+   canvas         cnv;
+   view&          view_;
+};
+
+// Some text: words of 1 to 10 letters, with a paragraph break every 80
+// words or so.
+std::string make_text(std::size_t size)
+{
+   std::mt19937 rng{ 1 };
+   std::uniform_int_distribution<int> word_length{ 1, 10 };
+   std::uniform_int_distribution<int> letter{ 'a', 'z' };
+   std::uniform_int_distribution<int> paragraph{ 0, 80 };
+
+   std::string text;
+   text.reserve(size);
+   while (text.size() < size)
+   {
+      for (int n = word_length(rng); n != 0; --n)
+         text += char(letter(rng));
+      text += paragraph(rng) ? ' ' : '\n';
+   }
+   text.resize(size);
+   return text;
+}
+
+// A log: one short numbered line per event
+std::string make_log(std::size_t lines)
+{
+   std::string text;
+   text.reserve(lines * 48);
+   for (std::size_t i = 0; i != lines; ++i)
+      text += "[" + std::to_string(i) + "] event handled without errors\n";
+   return text;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// vtile and htile limits and layout with 10k children
+///////////////////////////////////////////////////////////////////////////////
+void tile_benchmarks(suite& s, view& view_)
+{
+   constexpr std::size_t num_children = 10000;
+   constexpr float extent = num_children * 20;
+   scratch sc{ view_ };
+
+   auto vt = vtile_composite{};
+   auto ht = htile_composite{};
+   for (std::size_t i = 0; i != num_children; ++i)
+   {
+      vt.push_back(share(vsize(20, element{})));
+      ht.push_back(share(hsize(20, element{})));
+   }
+
+   s.run("vtile_limits_10k", 100,
+      [&](std::size_t)
+      {
+         vt.invalidate_limits();
+         do_not_optimize(vt.limits(sc.make_context(vt, {})));
+      }
+   );
+
+   s.run("htile_limits_10k", 100,
+      [&](std::size_t)
+      {
+         ht.invalidate_limits();
+         do_not_optimize(ht.limits(sc.make_context(ht, {})));
+      }
+   );
+
+   // Alternate the bounds so that every child moves and is laid out again
+   s.run("vtile_layout_10k", 100,
+      [&](std::size_t i)
+      {
+         auto ctx = sc.make_context(vt, { 0, 0, 500.0f + (i & 1), extent });
+         vt.limits(ctx);
+         vt.layout(ctx);
+      }
+   );
+
+   s.run("htile_layout_10k", 100,
+      [&](std::size_t i)
+      {
+         auto ctx = sc.make_context(ht, { 0, 0, extent, 20.0f + (i & 1) });
+         ht.limits(ctx);
+         ht.layout(ctx);
+      }
+   );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Tile space allocation: htile layout with 1k to 100k stretchable children
+// of varied minimum and maximum widths and stretch.
+///////////////////////////////////////////////////////////////////////////////
+void allocation_benchmarks(suite& s, view& view_)
+{
+   scratch sc{ view_ };
+   for (std::size_t n : { 1000, 10000, 100000 })
+   {
+      std::mt19937 rng{ 1 };
+      std::uniform_real_distribution<float> min_width{ 5, 20 };
+      std::uniform_real_distribution<float> extra_width{ 0, 40 };
+      std::uniform_real_distribution<float> stretch{ 0.5, 2 };
+
+      auto row = htile_composite{};
+      float total = 0;
+      for (std::size_t i = 0; i != n; ++i)
+      {
+         auto min_w = min_width(rng);
+         auto max_w = min_w + extra_width(rng);
+         total += max_w;
+         row.push_back(share(
+            hstretch(stretch(rng),
+               max_size({ max_w, full_extent },
+                  hmin_size(min_w, element{})
+               )
+            )
+         ));
+      }
+
+      // Give the row half of the space its children can take, so some
+      // children saturate and others share the rest
+      float width = total / 2;
+      auto name = "htile_allocate_" + std::to_string(n / 1000) + "k";
+      s.run(name, std::max<std::size_t>(1, 100000 / n),
+         [&](std::size_t i)
+         {
+            auto ctx = sc.make_context(row, { 0, 0, width + (i & 1), 20 });
+            row.limits(ctx);
+            row.layout(ctx);
+         }
+      );
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// composite_base::hit_element on a row of 10k children
+///////////////////////////////////////////////////////////////////////////////
+
+// hit_element finds controls only, so the children must be controls for
+// the points to hit anything
+struct hit_target : element
+{
+   bool is_control() const override   { return true; }
+};
+
+void hit_benchmarks(suite& s, view& view_)
+{
+   constexpr std::size_t num_children = 10000;
+   constexpr float extent = num_children * 20;
+   scratch sc{ view_ };
+
+   auto row = htile_composite{};
+   for (std::size_t i = 0; i != num_children; ++i)
+      row.push_back(share(hsize(20, hit_target{})));
+
+   auto ctx = sc.make_context(row, { 0, 0, extent, 20 });
+   row.limits(ctx);
+   row.layout(ctx);
+
+   std::mt19937 rng{ 1 };
+   std::uniform_real_distribution<float> x{ 0, extent };
+   std::vector<point> points;
+   for (int i = 0; i != 1000; ++i)
+      points.push_back({ x(rng), 10 });
+
+   s.run("hit_element_row_10k", 1000,
+      [&](std::size_t i)
+      {
+         do_not_optimize(row.hit_element(ctx, points[i % points.size()]));
+      }
+   );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// flowable_container::break_lines
+///////////////////////////////////////////////////////////////////////////////
+class flow_items : public flowable_container
+{
+public:
+
+   std::size_t    size() const override               { return _items.size(); }
+   element&       at(std::size_t ix) const override   { return *_items[ix]; }
+   void           push_back(element_ptr e)            { _items.push_back(e); }
+
+private:
+
+   std::vector<element_ptr> _items;
+};
+
+void flow_benchmarks(suite& s, view& view_)
+{
+   scratch sc{ view_ };
+
+   std::mt19937 rng{ 1 };
+   std::uniform_int_distribution<int> width{ 10, 100 };
+   flow_items items;
+   for (int i = 0; i != 10000; ++i)
+      items.push_back(share(hsize(float(width(rng)), element{})));
+
+   basic_context ctx{ view_, sc.cnv };
+   std::vector<element_ptr> rows;
+   s.run("flowable_container_break_lines_10k", 100,
+      [&](std::size_t)
+      {
+         rows.clear();
+         items.break_lines(rows, ctx, 800);
+      }
+   );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Text: master_glyphs on 1MB of text and basic_text_box editing
+///////////////////////////////////////////////////////////////////////////////
+void text_benchmarks(suite& s, view& view_)
+{
+   auto const& theme = get_theme();
+   auto text = make_text(1024 * 1024);
+   auto first = text.data();
+   auto last = first + text.size();
+
+   s.run("master_glyphs_build_1mb", 1,
+      [&](std::size_t)
+      {
+         master_glyphs master{ first, last, theme.text_box_font, theme.text_box_font_size };
+         do_not_optimize(master);
+      }
+   , 5
+   );
+
+   master_glyphs master{ first, last, theme.text_box_font, theme.text_box_font_size };
+   std::vector<glyphs> lines;
+   s.run("master_glyphs_break_lines_1mb", 1,
+      [&](std::size_t)
+      {
+         lines.clear();
+         master.break_lines(600, lines);
+      }
+   , 5
+   );
+
+   // Type into the middle of a text box. Only the edited paragraph is
+   // reshaped, so the cost should not grow with the size of the text.
+   scratch sc{ view_ };
+   auto keystroke = [&](char const* name, std::size_t size)
+   {
+      basic_text_box box{ make_text(size) };
+      auto ctx = sc.make_context(box, { 0, 0, 600, 0 });
+      auto limits = box.limits(ctx);
+      ctx.bounds.bottom = limits.min.y;
+      box.layout(ctx);
+      box.select_start(int(size / 2));
+      box.select_end(int(size / 2));
+
+      s.run(name, 10,
+         [&](std::size_t)
+         {
+            box.text(ctx, text_info{ 'x', 0 });
+         }
+      );
+   };
+
+   keystroke("basic_text_box_keystroke_64k", 64 * 1024);
+   keystroke("basic_text_box_keystroke_4mb", 4 * 1024 * 1024);
+
+   // Split and join a line with enter and backspace, and move the caret
+   // down and up, in the middle of a log. None of these should cost more
+   // with more lines.
+   auto keys = [&](std::string const& name, std::size_t lines)
+   {
+      auto log = make_log(lines);
+      basic_text_box box{ log };
+      auto ctx = sc.make_context(box, { 0, 0, 600, 0 });
+      auto limits = box.limits(ctx);
+      ctx.bounds.bottom = limits.min.y;
+      box.layout(ctx);
+      auto middle = int(log.find('\n', log.size() / 2) + 1);
+      box.select_start(middle);
+      box.select_end(middle);
+
+      auto press = [&](key_code key)
+      {
+         box.key(ctx, key_info{ key, key_action::press, 0 });
+      };
+
+      s.run("basic_text_box_enter_backspace_" + name, 10,
+         [&](std::size_t)
+         {
+            press(key_code::enter);
+            press(key_code::backspace);
+         }
+      );
+
+      s.run("basic_text_box_down_up_" + name, 10,
+         [&](std::size_t)
+         {
+            press(key_code::down);
+            press(key_code::up);
+         }
+      );
+   };
+
+   keys("4k_lines", 4 * 1024);
+   keys("1m_lines", 1024 * 1024);
+
+   // Draw 1MB of text through a 600x400 window, the way it would be
+   // drawn inside a scroller. Only the rows under the window should cost.
+   scratch window{ view_, { 600, 400 } };
+   static_text_box help{ text };
+   auto help_ctx = window.make_context(help, { 0, 0, 600, 0 });
+   help_ctx.bounds.bottom = help.limits(help_ctx).min.y;
+   help.layout(help_ctx);
+   help_ctx.bounds.bottom = help.limits(help_ctx).min.y;
+   help_ctx.bounds = help_ctx.bounds.move(0, -help_ctx.bounds.height() / 2);
+
+   view_.dirty(rect{ 0, 0, 600, 400 });
+   s.run("static_text_box_draw_1mb_window", 10,
+      [&](std::size_t)
+      {
+         help.draw(help_ctx);
+      }
+   );
+   view_.dirty(region{});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Graphics: pixmap decoding and gradient fills
+///////////////////////////////////////////////////////////////////////////////
+void pixmap_benchmarks(suite& s, view& view_)
+{
+   // Make a 512x512 png to decode
+   auto dir = fs::temp_directory_path() / fs::unique_path();
+   fs::create_directories(dir);
+   {
+      pixmap pm{ point{ 512, 512 } };
+      pixmap_context pm_ctx{ pm };
+      canvas cnv{ *pm_ctx.context() };
+      auto gr = canvas::radial_gradient{ { 256, 256 }, 0, { 256, 256 }, 256 };
+      gr.add_color_stop({ 0, colors::red });
+      gr.add_color_stop({ 1, colors::blue.opacity(0.5) });
+      cnv.fill_style(gr);
+      cnv.fill_rect({ 0, 0, 512, 512 });
+      cairo_surface_write_to_png(
+         cairo_get_target(pm_ctx.context()), (dir / "bench.png").string().c_str());
+   }
+   resource_paths.push_back(dir.string());
+
+   s.run("pixmap_decode_png_512", 10,
+      [&](std::size_t)
+      {
+         pixmap pm{ "bench.png" };
+         do_not_optimize(pm);
+      }
+   );
+
+   resource_paths.pop_back();
+   fs::remove_all(dir);
+}
+
+void gradient_benchmarks(suite& s, view& view_)
+{
+   scratch sc{ view_, { 1024, 1024 } };
+   auto& cnv = sc.cnv;
+
+   auto linear = canvas::linear_gradient{ { 0, 0 }, { 1024, 1024 } };
+   linear.add_color_stop({ 0, colors::red });
+   linear.add_color_stop({ 0.5, colors::green });
+   linear.add_color_stop({ 1, colors::blue });
+
+   s.run("canvas_linear_gradient_1024", 20,
+      [&](std::size_t)
+      {
+         cnv.fill_style(linear);
+         cnv.fill_rect({ 0, 0, 1024, 1024 });
+         cairo_surface_flush(cairo_get_target(&cnv.cairo_context()));
+      }
+   );
+
+   auto radial = canvas::radial_gradient{ { 512, 512 }, 0, { 512, 512 }, 512 };
+   radial.add_color_stop({ 0, colors::white });
+   radial.add_color_stop({ 1, colors::black });
+
+   s.run("canvas_radial_gradient_1024", 20,
+      [&](std::size_t)
+      {
+         cnv.fill_style(radial);
+         cnv.fill_rect({ 0, 0, 1024, 1024 });
+         cairo_surface_flush(cairo_get_target(&cnv.cairo_context()));
+      }
+   );
+}
+
+int main(int argc, char const* argv[])
+{
+   suite s{ argc > 1 ? argv[1] : "" };
+
+   window win("elements_benchmarks", window::standard, { 0, 0, 1024, 768 });
+   view view_(win);
+
+   tile_benchmarks(s, view_);
+   allocation_benchmarks(s, view_);
+   hit_benchmarks(s, view_);
+   flow_benchmarks(s, view_);
+   text_benchmarks(s, view_);
+   pixmap_benchmarks(s, view_);
+   gradient_benchmarks(s, view_);
+
+   s.write_json(stdout);
+   return 0;
+}
@@ -0,0 +1,72 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+///////////////////////////////////////////////////////////////////////////////
+// Full-window redraws of a 4K view, drawn with 1 to 16 threads.
+//
+//    usage: parallel_draw [frames]
+///////////////////////////////////////////////////////////////////////////////
+using namespace cycfi::elements;
+
+auto make_cell(int i)
+{
+   return layer(
+      margin({ 4, 4, 4, 4 }, label("Cell " + std::to_string(i))),
+      frame{},
+      panel{}
+   );
+}
+
+auto make_content()
+{
+   auto rows = vtile_composite{};
+   for (int r = 0; r != 64; ++r)
+   {
+      auto row = htile_composite{};
+      for (int c = 0; c != 32; ++c)
+         row.push_back(share(make_cell(r * 32 + c)));
+      rows.push_back(share(std::move(row)));
+   }
+   return rows;
+}
+
+int main(int argc, char const* argv[])
+{
+   int frames = argc > 1 ? std::atoi(argv[1]) : 20;
+
+   window win("parallel_draw", window::standard, { 0, 0, 3840, 2160 });
+   view view_(win);
+   view_.content({ share(make_content()) });
+
+   // Warm up: the first frame lays out the content
+   render(view_);
+
+   std::printf("threads, ms/frame, speedup\n");
+   double base = 0;
+   for (std::size_t threads = 1; threads <= 16; threads *= 2)
+   {
+      view_.parallel_draw(threads);
+
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i != frames; ++i)
+      {
+         view_.refresh();
+         render(view_);
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+         std::chrono::steady_clock::now() - start;
+
+      double ms = elapsed.count() / frames;
+      if (threads == 1)
+         base = ms;
+      std::printf("%zu, %.3f, %.2f\n", threads, ms, base / ms);
+   }
+   return 0;
+}
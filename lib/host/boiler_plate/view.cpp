@@ -25,6 +25,16 @@ namespace cycfi { namespace elements
    {
    }
 
+   void base_view::motion_history(bool keep)
+   {
+   }
+
+   std::vector<point> const& base_view::motion_history() const
+   {
+      static std::vector<point> const empty;
+      return empty;
+   }
+
    void base_view::refresh()
    {
    }
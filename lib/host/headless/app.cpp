@@ -0,0 +1,28 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/app.hpp>
+
+namespace cycfi { namespace elements
+{
+   app::app(int argc, const char* argv[])
+    : _app_name(argc > 0 ? argv[0] : "")
+   {
+   }
+
+   app::~app()
+   {
+   }
+
+   void app::run()
+   {
+      // There is no event loop in a headless host. The client drives the
+      // views directly and calls render when it wants a frame.
+   }
+
+   void app::stop()
+   {
+   }
+}}
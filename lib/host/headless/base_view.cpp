@@ -0,0 +1,191 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/base_view.hpp>
+#include <elements/headless.hpp>
+#include <elements/support/canvas.hpp>
+#include "headless_impl.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // _host_view
+   ////////////////////////////////////////////////////////////////////////////
+   _host_view::_host_view(elements::size size_)
+   {
+      resize(size_);
+   }
+
+   _host_view::~_host_view()
+   {
+      if (window && window->content == this)
+         window->content = nullptr;
+      if (surface)
+         cairo_surface_destroy(surface);
+      surface = nullptr;
+   }
+
+   void _host_view::resize(elements::size size_)
+   {
+      if (surface)
+         cairo_surface_destroy(surface);
+
+      size = size_;
+      surface = cairo_image_surface_create(
+         CAIRO_FORMAT_ARGB32
+       , std::max<int>(1, std::ceil(size.x))
+       , std::max<int>(1, std::ceil(size.y))
+      );
+      invalidate({ 0, 0, size.x, size.y });
+   }
+
+   void _host_view::invalidate(rect area)
+   {
+      area = clip(area, { 0, 0, size.x, size.y });
+      if (area.is_empty() || !is_valid(area))
+         return;
+      dirty = has_dirty ? max(dirty, area) : area;
+      has_dirty = true;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // base_view
+   ////////////////////////////////////////////////////////////////////////////
+   base_view::base_view(host_view h)
+    : _view(new _host_view(h->size))
+   {
+   }
+
+   base_view::base_view(host_window h)
+    : _view(new _host_view({ h->bounds.width(), h->bounds.height() }))
+   {
+      _view->window = h;
+      h->content = _view;
+   }
+
+   base_view::~base_view()
+   {
+      delete _view;
+   }
+
+   point base_view::cursor_pos() const
+   {
+      return _view->cursor_position;
+   }
+
+   elements::size base_view::size() const
+   {
+      return _view->size;
+   }
+
+   void base_view::size(elements::size p)
+   {
+      _view->resize(p);
+   }
+
+   void base_view::motion_history(bool keep)
+   {
+      _view->keep_motion_history = keep;
+   }
+
+   std::vector<point> const& base_view::motion_history() const
+   {
+      return _view->motion_history;
+   }
+
+   void base_view::refresh()
+   {
+      _view->invalidate({ 0, 0, _view->size.x, _view->size.y });
+   }
+
+   void base_view::refresh(rect area)
+   {
+      _view->invalidate(area);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Headless host API
+   ////////////////////////////////////////////////////////////////////////////
+   void render(base_view& v)
+   {
+      auto* h = v.host();
+      v.poll();
+
+      // The view asks for a full refresh and returns early when its limits
+      // change while drawing, so we allow one extra pass for that.
+      for (int pass = 0; pass != 2 && h->has_dirty; ++pass)
+      {
+         rect area = h->dirty;
+         h->has_dirty = false;
+
+         cairo_t* cr = cairo_create(h->surface);
+         cairo_rectangle(cr, area.left, area.top, area.width(), area.height());
+         cairo_clip(cr);
+
+         // Start from a clean background, like a freshly exposed window
+         cairo_set_source_rgba(cr, 0, 0, 0, 0);
+         cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+         cairo_paint(cr);
+         cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+         v.draw(cr, area);
+         cairo_destroy(cr);
+         cairo_surface_flush(h->surface);
+         v.poll();
+      }
+   }
+
+   rect dirty(base_view const& v)
+   {
+      auto* h = v.host();
+      return h->has_dirty ? h->dirty : rect{};
+   }
+
+   pixmap_ptr snapshot(base_view const& v)
+   {
+      auto* h = v.host();
+      auto  pm = std::make_shared<pixmap>(h->size);
+      pixmap_context pm_ctx{ *pm };
+      cairo_t* cr = pm_ctx.context();
+      cairo_set_source_surface(cr, h->surface, 0, 0);
+      cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+      cairo_paint(cr);
+      return pm;
+   }
+
+   void cursor_pos(base_view& v, point p)
+   {
+      v.host()->cursor_position = p;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // The clipboard is kept in memory so that cut, copy and paste can be
+   // exercised without a desktop session.
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      std::string& clipboard_data()
+      {
+         static std::string data;
+         return data;
+      }
+   }
+
+   std::string clipboard()
+   {
+      return clipboard_data();
+   }
+
+   void clipboard(std::string const& text)
+   {
+      clipboard_data() = text;
+   }
+
+   void set_cursor(cursor_type type)
+   {
+   }
+}}
@@ -0,0 +1,42 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_HOST_HEADLESS_IMPL_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_HOST_HEADLESS_IMPL_OCTOBER_16_2019
+
+#include <elements/base_view.hpp>
+#include <cairo.h>
+
+namespace cycfi { namespace elements
+{
+   struct _host_window
+   {
+      rect              bounds;
+      view_limits       limits      = full_limits;
+      _host_view*       content     = nullptr;
+   };
+
+   struct _host_view
+   {
+                        _host_view(elements::size size_);
+                        ~_host_view();
+
+      void              resize(elements::size size_);
+      void              invalidate(rect area);
+
+      cairo_surface_t*  surface     = nullptr;
+      elements::size    size;
+      rect              dirty;
+      bool              has_dirty   = false;
+      point             cursor_position;
+      _host_window*     window      = nullptr;
+
+      // Headless clients send events one at a time; nothing is coalesced
+      bool              keep_motion_history = false;
+      std::vector<point> motion_history;
+   };
+}}
+
+#endif
@@ -0,0 +1,69 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/headless.hpp>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      void dispatch(base_view& v, trace_event const& ev)
+      {
+         switch (ev.kind)
+         {
+            case trace_event::click:
+               cursor_pos(v, ev.button.pos);
+               v.click(ev.button);
+               break;
+
+            case trace_event::drag:
+               cursor_pos(v, ev.button.pos);
+               v.drag(ev.button);
+               break;
+
+            case trace_event::cursor:
+               cursor_pos(v, ev.pos);
+               v.cursor(ev.pos, ev.status);
+               break;
+
+            case trace_event::scroll:
+               cursor_pos(v, ev.pos);
+               v.scroll(ev.dir, ev.pos);
+               break;
+
+            case trace_event::key:
+               v.key(ev.key_);
+               break;
+
+            case trace_event::text:
+               v.text(ev.text_);
+               break;
+         }
+      }
+   }
+
+   std::vector<replay_latency> replay(base_view& v, event_trace const& trace)
+   {
+      using clock = std::chrono::steady_clock;
+
+      std::vector<replay_latency> result;
+      result.reserve(trace.size());
+
+      // Start from a fully rendered view
+      render(v);
+
+      for (auto const& ev : trace)
+      {
+         auto start = clock::now();
+         dispatch(v, ev);
+         auto dispatched = clock::now();
+         render(v);
+         auto rendered = clock::now();
+
+         result.push_back({ ev, dispatched - start, rendered - dispatched });
+      }
+      return result;
+   }
+}}
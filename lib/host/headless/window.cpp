@@ -0,0 +1,56 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#include <elements/window.hpp>
+#include <elements/support/misc.hpp>
+#include "headless_impl.hpp"
+
+namespace cycfi { namespace elements
+{
+   window::window(std::string const& name, int style_, rect const& bounds)
+    : _window(new _host_window{ bounds })
+   {
+   }
+
+   window::~window()
+   {
+      if (_window->content)
+         _window->content->window = nullptr;
+      delete _window;
+   }
+
+   point window::size() const
+   {
+      return { _window->bounds.width(), _window->bounds.height() };
+   }
+
+   void window::size(point const& p)
+   {
+      point size_ = p;
+      clamp(size_.x, _window->limits.min.x, _window->limits.max.x);
+      clamp(size_.y, _window->limits.min.y, _window->limits.max.y);
+
+      _window->bounds.width(size_.x);
+      _window->bounds.height(size_.y);
+      if (_window->content)
+         _window->content->resize({ size_.x, size_.y });
+   }
+
+   void window::limits(view_limits limits_)
+   {
+      _window->limits = limits_;
+      size(size());
+   }
+
+   point window::position() const
+   {
+      return _window->bounds.top_left();
+   }
+
+   void window::position(point const& p)
+   {
+      _window->bounds = _window->bounds.move_to(p.x, p.y);
+   }
+}}
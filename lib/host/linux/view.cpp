@@ -127,11 +127,31 @@ namespace cycfi { namespace elements
          return true;
       }
 
+      // Dispatch the motion held by on_motion, if any
+      void flush_motion(base_view& main_view, host_view* view)
+      {
+         if (!view->motion_pending)
+            return;
+         view->motion_pending = false;
+
+         std::swap(view->motion_history, view->pending_history);
+         view->pending_history.clear();
+
+         auto btn = view->motion_button;
+         if (btn.down)
+            main_view.drag(btn);
+         else
+            main_view.cursor(btn.pos, cursor_tracking::hovering);
+         view->motion_history.clear();
+      }
+
       gboolean on_button(GtkWidget* widget, GdkEventButton* event, gpointer user_data)
       {
          auto& main_view = get(user_data);
+         auto* host_view = platform_access::get_host_view(main_view);
          mouse_button btn;
-         if (get_button(event, btn, platform_access::get_host_view(main_view)))
+         flush_motion(main_view, host_view);
+         if (get_button(event, btn, host_view))
             main_view.click(btn);
          return TRUE;
       }
@@ -165,18 +185,40 @@ namespace cycfi { namespace elements
                btn.down = false;
             }
 
-            if (btn.down)
-               main_view.drag(btn);
-            else
-               main_view.cursor(view->cursor_position, cursor_tracking::hovering);
+            // High rate mice and tablets send many motion events per frame.
+            // Hold on to the latest and dispatch it on the next frame tick.
+            // A change of buttons is not coalesced with earlier motion.
+            if (view->motion_pending)
+            {
+               auto const& prev = view->motion_button;
+               if (prev.down != btn.down || (btn.down && prev.state != btn.state))
+                  flush_motion(main_view, view);
+               else if (view->keep_motion_history)
+                  view->pending_history.push_back(prev.pos);
+            }
+            view->motion_button = btn;
+            view->motion_pending = true;
          }
          return TRUE;
       }
 
+      gboolean on_tick(GtkWidget* widget, GdkFrameClock* clock, gpointer user_data)
+      {
+         // Tick callbacks run in the update phase of the widget's frame
+         // clock, right before layout and paint. Running the queued io
+         // work here (which includes flushing the view's damage) means we
+         // paint at most once per frame, in step with the display.
+         auto& main_view = get(user_data);
+         flush_motion(main_view, platform_access::get_host_view(main_view));
+         main_view.poll();
+         return G_SOURCE_CONTINUE;
+      }
+
       gboolean on_scroll(GtkWidget* widget, GdkEventScroll* event, gpointer user_data)
       {
          auto& main_view = get(user_data);
          auto* host_view = platform_access::get_host_view(main_view);
+         flush_motion(main_view, host_view);
          auto elapsed = std::max<float>(10.0f, event->time - host_view->scroll_time);
          static constexpr float _1s = 100;
          host_view->scroll_time = event->time;
@@ -219,6 +261,7 @@ namespace cycfi { namespace elements
    {
       auto& main_view = get(user_data);
       auto* host_view = platform_access::get_host_view(main_view);
+      flush_motion(main_view, host_view);
       host_view->cursor_position = point{ float(event->x), float(event->y) };
       main_view.cursor(
          host_view->cursor_position,
@@ -240,6 +283,9 @@ namespace cycfi { namespace elements
       g_signal_connect(G_OBJECT(drawing_area), "draw",
          G_CALLBACK(on_draw), &main_view);
 
+      // Drive the view from the frame clock
+      gtk_widget_add_tick_callback(drawing_area, on_tick, &main_view, nullptr);
+
       //gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER);
       gtk_window_set_default_size(GTK_WINDOW(window), 400, 300);
 
@@ -276,6 +322,16 @@ namespace cycfi { namespace elements
       return h->cursor_position;
    }
 
+   void base_view::motion_history(bool keep)
+   {
+      h->keep_motion_history = keep;
+   }
+
+   std::vector<point> const& base_view::motion_history() const
+   {
+      return h->motion_history;
+   }
+
    point base_view::size() const
    {
       auto x = gtk_widget_get_allocated_width(h->window);
@@ -10,6 +10,7 @@
 #include <elements/support/json_io.hpp>
 #include <gtk/gtk.h>
 #include <string>
+#include <vector>
 
 namespace cycfi { namespace elements
 {
@@ -47,6 +48,14 @@ namespace cycfi { namespace elements
       std::uint32_t scroll_time = 0;
 
       point cursor_position;
+
+      // Motion coalescing. Motion events are held here and dispatched once
+      // per frame (see on_motion and on_tick).
+      bool motion_pending = false;
+      mouse_button motion_button;
+      bool keep_motion_history = false;
+      std::vector<point> pending_history;    // Samples coalesced so far
+      std::vector<point> motion_history;     // Samples of the event being dispatched
    };
 
    config get_config();
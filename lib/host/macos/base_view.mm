@@ -563,6 +563,18 @@ namespace cycfi { namespace elements
       [get_mac_view(host()) setFrameSize : NSSize{ p.x, p.y }];
    }
 
+   // AppKit coalesces mouse motion itself and does not keep the coalesced
+   // samples, so there is no history to report.
+   void base_view::motion_history(bool keep)
+   {
+   }
+
+   std::vector<point> const& base_view::motion_history() const
+   {
+      static std::vector<point> const empty;
+      return empty;
+   }
+
    void base_view::refresh()
    {
       [get_mac_view(host()) setNeedsDisplay : YES];
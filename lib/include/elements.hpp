@@ -11,4 +11,8 @@
 #include <elements/view.hpp>
 #include <elements/element.hpp>
 
+#if defined(ELEMENTS_HOST_HEADLESS)
+# include <elements/headless.hpp>
+#endif
+
 #endif
\ No newline at end of file
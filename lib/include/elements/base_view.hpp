@@ -11,6 +11,7 @@
 #include <string>
 #include <cstdint>
 #include <functional>
+#include <vector>
 #include <cairo.h>
 
 #include <infra/support.hpp>
@@ -272,7 +273,10 @@ namespace cycfi { namespace elements
    // The base view base class
    ////////////////////////////////////////////////////////////////////////////
 
-#if defined(__APPLE__)
+#if defined(ELEMENTS_HOST_HEADLESS)
+   struct _host_view;
+   using host_view = _host_view*;
+#elif defined(__APPLE__)
    struct _host_view;
    using host_view = _host_view*;
 #elif defined(_WIN32)
@@ -281,7 +285,10 @@ namespace cycfi { namespace elements
    using host_view = GtkWidget*;
 #endif
 
-#if defined(__APPLE__)
+#if defined(ELEMENTS_HOST_HEADLESS)
+   struct _host_window;
+   using host_window = _host_window*;
+#elif defined(__APPLE__)
    struct _host_window;
    using host_window = _host_window*;
 #elif defined(_WIN32)
@@ -318,6 +325,15 @@ namespace cycfi { namespace elements
       void              size(elements::size p);
       host_view         host() const { return _view; }
 
+      // Motion history. Hosts may coalesce the mouse motion that arrives
+      // within a frame into one drag or cursor event with the latest
+      // position. Elements that want every sample (e.g. drawing tools) turn
+      // on motion_history(true), then, while handling the drag or cursor
+      // event, read the positions of the events that were coalesced into
+      // it, oldest first. The position of the event itself is not included.
+      void              motion_history(bool keep);
+      std::vector<point> const& motion_history() const;
+
    private:
 
       host_view         _view;
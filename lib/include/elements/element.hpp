@@ -9,6 +9,7 @@
 #include <elements/element/align.hpp>
 #include <elements/element/basics.hpp>
 #include <elements/element/button.hpp>
+#include <elements/element/cache.hpp>
 #include <elements/element/composite.hpp>
 #include <elements/element/dial.hpp>
 #include <elements/element/floating.hpp>
@@ -54,6 +54,7 @@ namespace cycfi { namespace elements
                      {}
 
       void           draw(context const& ctx);
+      bool           concurrent_draw() const    { return true; }
       color          _color;
    };
 
@@ -65,6 +66,7 @@ namespace cycfi { namespace elements
    public:
 
       virtual void draw(context const& ctx);
+      virtual bool concurrent_draw() const      { return true; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -73,6 +75,7 @@ namespace cycfi { namespace elements
    struct frame : public element
    {
       virtual void   draw(context const& ctx);
+      virtual bool   concurrent_draw() const    { return true; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -87,9 +90,10 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
       std::string             text() const                     { return _text; }
-      void                    text(std::string const& text)    { _text = text; }
+      void                    text(std::string const& text)    { _text = text; relimit_all(); }
 
       using element::text;
 
@@ -105,6 +109,7 @@ namespace cycfi { namespace elements
    public:
 
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -119,9 +124,10 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
       std::string             text() const                     { return _text; }
-      void                    text(std::string const& text)    { _text = text; }
+      void                    text(std::string const& text)    { _text = text; relimit_all(); }
 
       using element::text;
 
@@ -142,6 +148,7 @@ namespace cycfi { namespace elements
                               {}
 
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
    private:
 
@@ -158,6 +165,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
       std::uint32_t           _code;
       float                   _size;
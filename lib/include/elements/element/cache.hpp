@@ -0,0 +1,84 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_CACHE_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_CACHE_OCTOBER_16_2019
+
+#include <elements/element/proxy.hpp>
+#include <elements/support/pixmap_cache.hpp>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Cache elements
+   //
+   // Renders the subject once into a pixmap at the device scale, and blits
+   // the pixmap from then on. Use it for static decoration (e.g. panels,
+   // frames, dial and slider marks) that is costly to draw.
+   //
+   // The pixmap is rendered again when the bounds or the device scale
+   // change, when the subject is laid out again, when the theme changes
+   // (see theme_generation), after the subject handles an event or
+   // receives a value, when the subject or any of its descendants is
+   // refreshed through view::refresh(element&), or when invalidate() is
+   // called.
+   //
+   // Pixmaps are held by the view's pixmap_cache under a memory budget.
+   // A pixmap evicted from the cache is simply rendered again.
+   ////////////////////////////////////////////////////////////////////////////
+   class cache_element : public proxy_base
+   {
+   public:
+
+                              ~cache_element();
+
+   // Image
+
+      virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return false; }
+      virtual void            layout(context const& ctx);
+      virtual void            refresh(context const& ctx, element& element);
+      virtual bool            scroll(context const& ctx, point dir, point p);
+
+      using element::refresh;
+
+   // Control
+
+      virtual element*        click(context const& ctx, mouse_button btn);
+      virtual void            drag(context const& ctx, mouse_button btn);
+      virtual bool            key(context const& ctx, key_info k);
+      virtual bool            text(context const& ctx, text_info info);
+      virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
+
+   // Receiver
+
+      virtual void            value(bool val);
+      virtual void            value(int val);
+      virtual void            value(double val);
+      virtual void            value(std::string val);
+
+   // Cache
+
+      void                    invalidate()                     { _valid = false; }
+
+   private:
+
+      bool                    _valid = false;
+      std::weak_ptr<pixmap_cache> _cache;
+      rect                    _bounds;
+      float                   _scale = 0;
+      std::size_t             _generation = 0;
+   };
+
+   template <typename Subject>
+   inline proxy<Subject, cache_element>
+   cache(Subject&& subject)
+   {
+      return { std::forward<Subject>(subject) };
+   }
+}}
+
+#endif
@@ -7,8 +7,10 @@
 #define CYCFI_ELEMENTS_GUI_LIB_COMPOSITE_APRIL_10_2016
 
 #include <elements/element/element.hpp>
+#include <elements/support/grid_index.hpp>
 #include <vector>
 #include <array>
+#include <utility>
 
 namespace cycfi { namespace elements
 {
@@ -37,6 +39,7 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const = 0;
       virtual element*        hit_test(context const& ctx, point p);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const;
       virtual void            layout(context const& ctx) = 0;
       virtual bool            scroll(context const& ctx, point dir, point p);
       virtual void            refresh(context const& ctx, element& element);
@@ -70,10 +73,66 @@ namespace cycfi { namespace elements
       virtual hit_info        hit_element(context const& ctx, point p) const;
       virtual rect            bounds_of(context const& ctx, std::size_t index) const = 0;
 
+   // Spatial index
+
+      // When enabled, hit_element looks up the children that may include
+      // the point in a uniform grid (see grid_index), built from bounds_of
+      // the first time it is needed after a layout. This pays off for
+      // composites with many children placed freely; tiles already find
+      // their children by binary search.
+      void                    spatial_index(bool enable);
+      bool                    spatial_index() const            { return _use_index; }
+
+   // Limits cache
+
+      virtual void            invalidate_limits();
+
+   // Incremental layout
+
+      bool                    needs_layout(context const& ctx) const;
+
+   protected:
+
+      bool                    limits_cached() const;
+      view_limits             cached_limits() const            { return _limits; }
+      view_limits             cache_limits(basic_context const& ctx, view_limits limits_) const;
+      view_limits             limits_of(basic_context const& ctx, std::size_t index) const;
+
+      hit_info                hit_child(context const& ctx, point p, std::size_t index) const;
+      grid_index const&       index(context const& ctx) const;
+
+      // Call when the element under the cursor may have changed without a
+      // layout (e.g. a deck selecting another page)
+      void                    invalidate_cursor();
+
+      // True if the children may overlap, the later ones on top (e.g.
+      // layers). The cursor fast path then checks that no later child is
+      // under the cursor.
+      virtual bool            overlapping() const              { return false; }
+
+      bool                    begin_layout(context const& ctx);
+      void                    layout_child(
+                                 context const& ctx, element& e
+                               , rect bounds, bool moved);
+
    private:
 
       void                    new_focus(context const& ctx, int index);
 
+      rect                    _layout_bounds;
+      std::size_t             _layout_generation = 0;
+      std::size_t             _layout_count = 0;
+      std::size_t             _cursor_layout = 0;
+      mutable std::size_t     _concurrent_layout = -1;
+      mutable bool            _concurrent = false;
+
+      mutable view_limits     _limits;
+      mutable std::vector<view_limits> _child_limits;
+      mutable std::size_t     _limits_generation = 0;
+
+      bool                    _use_index = false;
+      mutable grid_index      _index;
+
       int                     _focus = -1;
       int                     _saved_focus = -1;
       int                     _drag_tracking = -1;
@@ -90,12 +149,50 @@ namespace cycfi { namespace elements
       using base_type = Base;
       using container_type = Container;
       using Container::Container;
-      using Container::operator=;
+
+                              composite() = default;
+                              composite(composite const&) = default;
+                              composite(composite&&) = default;
+
+      composite&              operator=(composite const& rhs);
+      composite&              operator=(composite&& rhs);
+      composite&              operator=(Container const& rhs);
+      composite&              operator=(Container&& rhs);
 
       virtual std::size_t     size() const               { return Container::size(); };
       virtual element&        at(std::size_t ix) const   { return *(*this)[ix].get(); }
 
       using Container::empty;
+
+      // Changing the children drops the cached limits of this composite
+      // and marks it for layout. The ancestors of a composite that is
+      // already in a view may still hold its old limits: follow the change
+      // with relimit(ctx), or relimit_all() if there is no context. So must
+      // a child replaced in place (e.g. c[i] = e).
+                              template <typename... T>
+      void                    push_back(T&&... args);
+
+                              template <typename... T>
+      decltype(auto)          emplace_back(T&&... args);
+
+                              template <typename... T>
+      decltype(auto)          insert(T&&... args);
+
+                              template <typename... T>
+      decltype(auto)          emplace(T&&... args);
+
+                              template <typename... T>
+      decltype(auto)          erase(T&&... args);
+
+                              template <typename... T>
+      void                    resize(T&&... args);
+
+      void                    pop_back();
+      void                    clear();
+
+   private:
+
+      void                    children_changed();
    };
 
    template <size_t N, typename Base>
@@ -104,6 +201,117 @@ namespace cycfi { namespace elements
    template <typename Base>
    using vector_composite = composite<std::vector<element_ptr>, Base>;
 
+   ////////////////////////////////////////////////////////////////////////////
+   // composite inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename Container, typename Base>
+   inline composite<Container, Base>&
+   composite<Container, Base>::operator=(composite const& rhs)
+   {
+      Base::operator=(rhs);
+      Container::operator=(rhs);
+      children_changed();
+      return *this;
+   }
+
+   template <typename Container, typename Base>
+   inline composite<Container, Base>&
+   composite<Container, Base>::operator=(composite&& rhs)
+   {
+      Base::operator=(std::move(rhs));
+      Container::operator=(std::move(rhs));
+      children_changed();
+      return *this;
+   }
+
+   template <typename Container, typename Base>
+   inline composite<Container, Base>&
+   composite<Container, Base>::operator=(Container const& rhs)
+   {
+      Container::operator=(rhs);
+      children_changed();
+      return *this;
+   }
+
+   template <typename Container, typename Base>
+   inline composite<Container, Base>&
+   composite<Container, Base>::operator=(Container&& rhs)
+   {
+      Container::operator=(std::move(rhs));
+      children_changed();
+      return *this;
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline void composite<Container, Base>::push_back(T&&... args)
+   {
+      children_changed();
+      Container::push_back(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline decltype(auto) composite<Container, Base>::emplace_back(T&&... args)
+   {
+      children_changed();
+      return Container::emplace_back(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline decltype(auto) composite<Container, Base>::insert(T&&... args)
+   {
+      children_changed();
+      return Container::insert(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline decltype(auto) composite<Container, Base>::emplace(T&&... args)
+   {
+      children_changed();
+      return Container::emplace(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline decltype(auto) composite<Container, Base>::erase(T&&... args)
+   {
+      children_changed();
+      return Container::erase(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   template <typename... T>
+   inline void composite<Container, Base>::resize(T&&... args)
+   {
+      children_changed();
+      Container::resize(std::forward<T>(args)...);
+   }
+
+   template <typename Container, typename Base>
+   inline void composite<Container, Base>::pop_back()
+   {
+      children_changed();
+      Container::pop_back();
+   }
+
+   template <typename Container, typename Base>
+   inline void composite<Container, Base>::clear()
+   {
+      children_changed();
+      Container::clear();
+   }
+
+   template <typename Container, typename Base>
+   inline void composite<Container, Base>::children_changed()
+   {
+      Base::invalidate_limits();
+      Base::layout_dirty(true);
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
    template <typename Base>
    class range_composite : public Base
    {
@@ -47,6 +47,7 @@ namespace cycfi { namespace elements
       virtual view_stretch    stretch() const;
       virtual element*        hit_test(context const& ctx, point p);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const;
       virtual void            layout(context const& ctx);
       virtual bool            scroll(context const& ctx, point dir, point p);
       virtual void            refresh(context const& ctx, element& element);
@@ -65,14 +66,62 @@ namespace cycfi { namespace elements
       virtual element*        focus();
       virtual bool            is_control() const;
 
+   // Limits cache
+
+      virtual void            invalidate_limits();
+      void                    relimit(context const& ctx);
+
+   // Layout state
+
+      bool                    layout_dirty() const             { return _layout_dirty; }
+      void                    layout_dirty(bool dirty)         { _layout_dirty = dirty; }
+      void                    relayout(context const& ctx);
+
    // Receiver
 
       virtual void            value(bool val);
       virtual void            value(int val);
       virtual void            value(double val);
       virtual void            value(std::string val);
+
+   private:
+
+      bool                    _layout_dirty = true;
    };
 
+   ////////////////////////////////////////////////////////////////////////////
+   // Concurrent drawing
+   //
+   // When the view draws in parallel (see view::parallel_draw), an element
+   // may be drawn by several threads at once, each for a different tile of
+   // the view. concurrent_draw() returns true if draw is safe to run that
+   // way: it must not modify the element or any shared state, and it must
+   // not call into the host (e.g. view::cursor_pos). This is an explicit
+   // trait: an element opts in by overriding concurrent_draw. The default
+   // is false. Composites and proxies support it if all their children
+   // (or their subject) do. Composites cache the answer until their next
+   // layout.
+   ////////////////////////////////////////////////////////////////////////////
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Limits cache
+   //
+   // Composites memoize the limits of their children. An element whose
+   // limits change after it was measured must say so: relimit(ctx) drops
+   // the cached limits of the element and of all its ancestors along the
+   // context chain. Without a context (e.g. when a label's text is set by
+   // the application), relimit_all() drops all cached limits. Caches are
+   // stamped with limits_generation(); a stale stamp is a cache miss.
+   //
+   // Layout is incremental as well. Each element has a layout-dirty bit.
+   // relayout(ctx) sets it on the element and its ancestors (relimit(ctx)
+   // implies relayout(ctx)). Composites lay out a child again only if the
+   // child is dirty or its bounds changed; all other children keep their
+   // layout.
+   ////////////////////////////////////////////////////////////////////////////
+   void                       relimit_all();
+   std::size_t                limits_generation();
+
    ////////////////////////////////////////////////////////////////////////////
    using element_ptr = std::shared_ptr<element>;
    using element_const_ptr = std::shared_ptr<element const>;
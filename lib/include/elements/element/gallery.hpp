@@ -157,6 +157,7 @@ namespace cycfi { namespace elements
 
                               basic_button_body(color body_color);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
       color                   body_color;
    };
@@ -507,6 +508,7 @@ inline Button make_button(
    struct menu_background : element
    {
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -526,6 +528,7 @@ inline Button make_button(
    {
       virtual view_limits limits(basic_context const& ctx) const;
       virtual void          draw(context const& ctx);
+      virtual bool          concurrent_draw() const   { return true; }
    };
 
    inline auto menu_item_spacer()
@@ -25,6 +25,7 @@ namespace cycfi { namespace elements
       point                   size() const;
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
       virtual rect            source_rect(context const& ctx) const;
 
    protected:
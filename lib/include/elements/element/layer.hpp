@@ -26,10 +26,19 @@ namespace cycfi { namespace elements
 
       using composite_base::focus;
 
+   protected:
+
+      virtual bool            overlapping() const              { return true; }
+
    private:
 
       void                    focus_top();
+      rect                    child_bounds(context const& ctx, std::size_t index) const;
+
       rect                    bounds;
+
+      // The bounds of each child, computed at layout time
+      std::vector<rect>       _bounds;
    };
 
    using layer_composite = vector_composite<layer_element>;
@@ -66,6 +75,11 @@ namespace cycfi { namespace elements
       void                 select(std::size_t index);
       std::size_t          selected() const { return _selected_index; }
 
+   protected:
+
+      // Only the selected child is hit (see select)
+      virtual bool         overlapping() const { return false; }
+
    private:
 
       std::size_t          _selected_index;
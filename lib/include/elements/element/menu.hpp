@@ -59,6 +59,7 @@ namespace cycfi { namespace elements
       using menu_item_function = std::function<void()>;
 
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return false; }
       virtual element*        hit_test(context const& ctx, point p);
       virtual element*        click(context const& ctx, mouse_button btn);
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
@@ -28,6 +28,7 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            prepare_subject(context& ctx);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return false; }
 
       double                  halign() const { return _halign; }
       void                    halign(double val) { _halign = val; }
@@ -60,6 +61,7 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            prepare_subject(context& ctx);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return false; }
 
       double                  valign() const { return _valign; }
       void                    valign(double val) { _valign = val; }
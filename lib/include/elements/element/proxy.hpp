@@ -27,6 +27,7 @@ namespace cycfi { namespace elements
       virtual view_stretch    stretch() const;
       virtual element*        hit_test(context const& ctx, point p);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const;
       virtual void            layout(context const& ctx);
       virtual void            refresh(context const& ctx, element& element);
       virtual bool            scroll(context const& ctx, point dir, point p);
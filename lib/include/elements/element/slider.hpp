@@ -32,6 +32,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const;
       virtual void            layout(context const& ctx);
 
       virtual bool            scroll(context const& ctx, point dir, point p);
@@ -193,6 +194,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
    private:
 
@@ -242,6 +244,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
    private:
 
@@ -7,10 +7,12 @@
 #define CYCFI_ELEMENTS_GUI_LIB_WIDGET_TEXT_APRIL_17_2016
 
 #include <elements/support/glyphs.hpp>
+#include <elements/support/text_buffer.hpp>
 #include <elements/support/theme.hpp>
 #include <elements/element/element.hpp>
 #include <boost/asio.hpp>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace cycfi { namespace elements
@@ -37,24 +39,84 @@ namespace cycfi { namespace elements
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return true; }
 
-      std::string const&      text() const                     { return _text; }
+      // The whole text as one string. This flattens the text buffer, O(n)
+      // after an edit: in the editing paths, use _text instead.
+      std::string const&      text() const                     { return _text.str(); }
       virtual void            text(std::string const& text);
       virtual void            value(std::string val);
 
       using element::text;
 
-   private:
+   protected:
 
-      void                    sync() const;
+      // Each paragraph of the text is shaped and broken into rows on its
+      // own. An edit reshapes only the paragraphs it changed.
+      struct paragraph
+      {
+         text_buffer::paragraph_ptr text;
+         master_glyphs        layout;
+         std::vector<glyphs>  rows;
+      };
 
-   protected:
+      // The paragraphs, kept in chunks of a few hundred, each chunk with
+      // the first row of each of its paragraphs. Adding or removing
+      // paragraphs, or finding the paragraph at a row, touches one chunk
+      // and the per chunk index: O(chunk + n/chunk) instead of O(n).
+      class paragraph_list
+      {
+      public:
+
+         using shaped_list = std::vector<paragraph>;
+
+         std::size_t          size() const                     { return _first.back(); }
+         std::size_t          rows() const                     { return _first_row.back(); }
+
+         paragraph&           operator[](std::size_t i);
+         paragraph const&     operator[](std::size_t i) const;
+         std::size_t          first_row(std::size_t i) const;
+         std::size_t          find_row(std::size_t row) const;
+
+         void                 replace(std::size_t first, std::size_t last, shaped_list&& with);
+         void                 reindex(std::size_t first, std::size_t last);
+         void                 reindex()                        { reindex(0, size()); }
 
-      std::string             _text;
-      mutable master_glyphs   _layout;
-      std::vector<glyphs>     _rows;
+      private:
+
+         struct chunk
+         {
+            shaped_list                paragraphs;
+            std::vector<std::size_t>   first_row;  // of each paragraph, then the total
+         };
+
+         using location = std::pair<std::size_t, std::size_t>;
+
+         location             find(std::size_t i) const;
+         void                 index_chunk(chunk& c);
+         void                 index(std::size_t first_chunk);
+
+         std::vector<chunk>         _chunks;
+         std::vector<std::size_t>   _first = { 0 };      // first paragraph of each chunk, then the total
+         std::vector<std::size_t>   _first_row = { 0 };  // first row of each chunk, then the total
+      };
+
+      void                    sync(float width);
+      std::size_t             num_rows() const                 { return _paragraphs.rows(); }
+      std::size_t             paragraph_of_row(std::size_t row) const;
+
+      text_buffer             _text;
+      master_glyphs           _layout;       // holds the font
+      paragraph_list          _paragraphs;
+      float                   _wrap_width = -1;
+      std::size_t             _synced_revision = 0;   // of _text, as last synced
       color                   _color;
       point                   _current_size = { -1, -1 };
+
+   private:
+
+      paragraph               shape(std::size_t i) const;
+      void                    wrap(paragraph& para, float width);
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -72,6 +134,7 @@ namespace cycfi { namespace elements
                               basic_text_box(basic_text_box&& rhs) = default;
 
       virtual void            draw(context const& ctx);
+      virtual bool            concurrent_draw() const          { return false; }
       virtual element*        click(context const& ctx, mouse_button btn);
       virtual void            drag(context const& ctx, mouse_button btn);
       virtual bool            cursor(context const& ctx, point p, cursor_tracking status);
@@ -110,8 +173,8 @@ namespace cycfi { namespace elements
          float       line_height;   // Line height
       };
 
-      char const*             caret_position(context const& ctx, point p);
-      glyph_metrics           glyph_info(context const& ctx, char const* s);
+      int                     caret_position(context const& ctx, point p);
+      glyph_metrics           glyph_info(context const& ctx, int pos);
 
       virtual void            delete_();
       virtual void            cut(view& v, int start, int end);
@@ -20,6 +20,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
+      virtual hit_info        hit_element(context const& ctx, point p) const;
       virtual rect            bounds_of(context const& ctx, std::size_t index) const;
 
    private:
@@ -50,6 +51,7 @@ namespace cycfi { namespace elements
 
       virtual view_limits     limits(basic_context const& ctx) const;
       virtual void            layout(context const& ctx);
+      virtual hit_info        hit_element(context const& ctx, point p) const;
       virtual rect            bounds_of(context const& ctx, std::size_t index) const;
 
    private:
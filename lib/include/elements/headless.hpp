@@ -0,0 +1,60 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License (https://opensource.org/licenses/MIT)
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_HEADLESS_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_HEADLESS_OCTOBER_16_2019
+
+#include <elements/base_view.hpp>
+#include <elements/support/pixmap.hpp>
+#include <elements/support/rect.hpp>
+#include <elements/support/event_trace.hpp>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Headless host
+   //
+   // When the library is built with ELEMENTS_HOST_HEADLESS, views render
+   // into an offscreen cairo image surface. There is no window and no
+   // display server. The client drives the view by calling its click,
+   // drag, cursor, scroll, key and text member functions directly, then
+   // calls render to paint whatever was invalidated since the last frame.
+   // This is useful for benchmarking and testing the element tree on build
+   // machines.
+   ////////////////////////////////////////////////////////////////////////////
+
+   // Drain the view's pending io work and paint the invalidated region.
+   void           render(base_view& v);
+
+   // The region invalidated since the last render (empty if none).
+   rect           dirty(base_view const& v);
+
+   // Copy the most recently rendered frame into a new pixmap.
+   pixmap_ptr     snapshot(base_view const& v);
+
+   // Set the position reported by base_view::cursor_pos(). A window host
+   // tracks the mouse for us; a headless client calls this before sending
+   // synthetic cursor and drag events.
+   void           cursor_pos(base_view& v, point p);
+
+   // Replay a recorded event trace (see view::recorder) against the view,
+   // as fast as possible. Each event is dispatched to the view, then the
+   // frame is rendered. For each event, we report the time spent in the
+   // view's event handler (click, drag, cursor, scroll, key or text) and
+   // the time spent rendering the frame that follows.
+   struct replay_latency
+   {
+      using duration = trace_event::duration;
+
+      trace_event    event;
+      duration       dispatch;
+      duration       frame;
+   };
+
+   std::vector<replay_latency> replay(base_view& v, event_trace const& trace);
+}}
+
+#endif
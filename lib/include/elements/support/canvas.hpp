@@ -61,6 +61,7 @@ namespace cycfi { namespace elements
       void              clip();
       bool              hit_test(point p) const;
       elements::rect      fill_extent() const;
+      elements::rect      clip_extent() const;
 
       void              move_to(point p);
       void              line_to(point p);
@@ -122,6 +122,13 @@ namespace cycfi { namespace elements
       return elements::rect(x1, y1, x2, y2);
    }
 
+   inline rect canvas::clip_extent() const
+   {
+      double x1, y1, x2, y2;
+      cairo_clip_extents(&_context, &x1, &y1, &x2, &y2);
+      return elements::rect(x1, y1, x2, y2);
+   }
+
    inline void canvas::move_to(point p)
    {
       cairo_move_to(&_context, p.x, p.y);
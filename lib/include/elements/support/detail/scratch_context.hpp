@@ -3,6 +3,9 @@
 
    Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
 =============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_SCRATCH_CONTEXT_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_SCRATCH_CONTEXT_OCTOBER_16_2019
+
 #include "cairo.h"
 
 namespace cycfi { namespace elements { namespace detail
@@ -33,3 +36,5 @@ namespace cycfi { namespace elements { namespace detail
       cairo_t*          _context;
    };
 }}}
+
+#endif
@@ -0,0 +1,104 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_DRAW_PROFILER_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_DRAW_PROFILER_OCTOBER_16_2019
+
+#include <elements/support/rect.hpp>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // draw_profiler
+   //
+   // Records how long each element takes to draw, for one frame at a time.
+   // Install a profiler with view::profiler(p); composites and proxies then
+   // time the draw of each child they visit, tagged with the child's
+   // dynamic type name and bounds. Since children draw inside their
+   // parent's draw, the timings nest, and write_trace exports them as
+   // Chrome trace_event JSON (load it in chrome://tracing or Perfetto) for
+   // a flame view of the frame.
+   //
+   // The profiler is cleared at the start of each frame, so after drawing,
+   // it holds the last frame drawn.
+   ////////////////////////////////////////////////////////////////////////////
+   class draw_profiler
+   {
+   public:
+
+      using clock = std::chrono::steady_clock;
+
+      struct event
+      {
+         std::string const*   name;
+         rect                 bounds;
+         clock::time_point    start;
+         clock::time_point    stop;
+         std::thread::id      thread;
+      };
+
+      class scope
+      {
+      public:
+                              scope(draw_profiler* p, element const& e, rect bounds);
+                              ~scope();
+
+                              scope(scope const&) = delete;
+         scope&               operator=(scope const&) = delete;
+
+      private:
+
+         draw_profiler*       _profiler;
+         element const*       _element;
+         rect                 _bounds;
+         clock::time_point    _start;
+      };
+
+      void                    begin_frame();
+      std::vector<event>      events() const;
+      void                    write_trace(std::ostream& out) const;
+
+   private:
+
+      void                    record(element const& e, rect bounds, clock::time_point start);
+
+      using names_map = std::unordered_map<std::type_index, std::string>;
+
+      mutable std::mutex      _mutex;
+      clock::time_point       _frame_start;
+      std::vector<event>      _events;
+      names_map               _names;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   inline draw_profiler::scope::scope(draw_profiler* p, element const& e, rect bounds)
+    : _profiler(p)
+    , _element(&e)
+    , _bounds(bounds)
+   {
+      if (_profiler)
+         _start = clock::now();
+   }
+
+   inline draw_profiler::scope::~scope()
+   {
+      if (_profiler)
+         _profiler->record(*_element, _bounds, _start);
+   }
+}}
+
+#endif
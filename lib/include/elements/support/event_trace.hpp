@@ -0,0 +1,88 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_EVENT_TRACE_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_EVENT_TRACE_OCTOBER_16_2019
+
+#include <elements/base_view.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Input event traces
+   //
+   // An event_trace records the input events that reach a view (see
+   // view::recorder), each stamped with its time since recording started.
+   // Traces are saved in a compact binary format and can be replayed
+   // against the same content with the headless host (see
+   // elements/headless.hpp), e.g. to turn a report of sluggish typing into
+   // a repeatable performance test.
+   ////////////////////////////////////////////////////////////////////////////
+   struct trace_event
+   {
+      enum kind_type : std::uint8_t
+      {
+         click, drag, cursor, scroll, key, text
+      };
+
+      using duration = std::chrono::duration<double>;
+
+      duration             time;    // Time since the start of the trace
+      kind_type            kind;
+
+      // The payload. Only the fields that apply to the kind are meaningful.
+      mouse_button         button = {};
+      cursor_tracking      status = cursor_tracking::hovering;
+      point                pos;     // cursor and scroll position
+      point                dir;     // scroll direction
+      key_info             key_ = {};
+      text_info            text_ = {};
+   };
+
+   struct failed_to_load_event_trace : std::runtime_error
+   {
+      using std::runtime_error::runtime_error;
+   };
+
+   class event_trace
+   {
+   public:
+
+      using events_type = std::vector<trace_event>;
+      using const_iterator = events_type::const_iterator;
+
+      void                 record_click(mouse_button btn);
+      void                 record_drag(mouse_button btn);
+      void                 record_cursor(point p, cursor_tracking status);
+      void                 record_scroll(point dir, point p);
+      void                 record_key(key_info const& k);
+      void                 record_text(text_info const& info);
+
+      void                 clear();
+      bool                 empty() const              { return _events.empty(); }
+      std::size_t          size() const               { return _events.size(); }
+      const_iterator       begin() const              { return _events.begin(); }
+      const_iterator       end() const                { return _events.end(); }
+
+      void                 save(std::ostream& out) const;
+      void                 load(std::istream& in);
+
+   private:
+
+      using clock = std::chrono::steady_clock;
+
+      trace_event&         add(trace_event::kind_type kind);
+
+      events_type          _events;
+      clock::time_point    _start;
+   };
+}}
+
+#endif
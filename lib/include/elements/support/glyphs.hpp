@@ -11,6 +11,7 @@
 #include <elements/support/text_utils.hpp>
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
 #include <cairo.h>
 
 namespace cycfi { namespace elements
@@ -39,6 +40,19 @@ namespace cycfi { namespace elements
                            template <typename F>
       void                 for_each(F f);
 
+      struct cluster_info
+      {
+         char const*       utf8;          // null if there is no such cluster
+         float             left;
+         float             right;
+      };
+
+                           // The cluster at x, relative to the left of the
+                           // glyphs, and the first cluster at or after utf8.
+                           // Both are binary searches.
+      cluster_info         hit_test(float x) const;
+      cluster_info         locate(char const* utf8) const;
+
       std::size_t          size() const      { return _last - _first; }
       char const*          begin() const     { return _first; }
       char const*          end() const       { return _last; }
@@ -55,6 +69,8 @@ namespace cycfi { namespace elements
    protected:
                            glyphs(char const* first, char const* last);
 
+      friend class master_glyphs;
+
       using scaled_font = cairo_scaled_font_t;
       using glyph = cairo_glyph_t;
       using cluster = cairo_text_cluster_t;
@@ -68,6 +84,12 @@ namespace cycfi { namespace elements
       cluster*             _clusters      = nullptr;
       int                  _cluster_count = 0;
       cluster_flags        _clusterflags;
+
+      // Per cluster left and right edges and byte offsets, owned by the
+      // master
+      float const*         _lefts         = nullptr;
+      float const*         _rights        = nullptr;
+      int const*           _offsets       = nullptr;
    };
 
    ////////////////////////////////////////////////////////////////////////////
@@ -103,38 +125,43 @@ namespace cycfi { namespace elements
                            master_glyphs(master_glyphs const&) = delete;
       master_glyphs&       operator=(master_glyphs const& rhs) = delete;
 
+      friend class glyphs;
+      using bitmap = std::vector<std::uint64_t>;
+
       void                 build();
+      void                 move(master_glyphs& rhs);
+
+      // Per cluster metrics, computed once by build(): the left edge and
+      // the right edge (never decreasing) of each cluster's first glyph,
+      // where each cluster starts in the glyphs and in the text, and
+      // bitmaps of the clusters that start with a space or a newline.
+      std::vector<float>   _left_x;
+      std::vector<float>   _right_x;
+      std::vector<int>     _glyph_start;
+      std::vector<int>     _byte_start;
+      bitmap               _spaces;
+      bitmap               _newlines;
    };
 
    ////////////////////////////////////////////////////////////////////////////
    template <typename F>
    inline void glyphs::for_each(F f)
    {
-      CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
-      CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
-      CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
-
       if (_first == _last)
          return;
 
-      int   glyph_index = 0;
+      CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
+      CYCFI_ASSERT(_lefts, "Precondition failure: _lefts must not be null");
+      CYCFI_ASSERT(_rights, "Precondition failure: _rights must not be null");
+
       int   byte_index = 0;
-      float start_x = _glyphs->x;
+      float start_x = _lefts[0];
 
       for (int i = 0; i < _cluster_count; i++)
       {
-         cairo_text_cluster_t* cluster = _clusters + i;
-         cairo_glyph_t* glyph = _glyphs + glyph_index;
-         cairo_text_extents_t extents;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-
-         float x = glyph->x - start_x;
-         if (!f(_first + byte_index, x, x + extents.x_advance))
+         if (!f(_first + byte_index, _lefts[i] - start_x, _rights[i] - start_x))
             break;
-
-         // glyph/byte position
-         glyph_index += cluster->num_glyphs;
-         byte_index += cluster->num_bytes;
+         byte_index += _clusters[i].num_bytes;
       }
    }
 }}
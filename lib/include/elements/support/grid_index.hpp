@@ -0,0 +1,66 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_GRID_INDEX_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_GRID_INDEX_OCTOBER_16_2019
+
+#include <elements/support/rect.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // grid_index
+   //
+   // A uniform grid over a set of rects, for finding the rects that may
+   // include a point without testing them all. Each cell lists, in
+   // ascending order, the indices of the rects that overlap it. The grid
+   // has about one cell per rect.
+   //
+   // The grid is built for some bounds (e.g. a composite's), but it spans
+   // the rects as well, wherever they are, so that rects reaching outside
+   // the bounds are found too.
+   ////////////////////////////////////////////////////////////////////////////
+   class grid_index
+   {
+   public:
+
+      using index_type = std::uint32_t;
+
+      struct range
+      {
+         index_type const*    first;
+         index_type const*    last;
+
+         index_type const*    begin() const     { return first; }
+         index_type const*    end() const       { return last; }
+         bool                 empty() const     { return first == last; }
+      };
+
+      void                    build(rect bounds, std::vector<rect> const& rects);
+      void                    clear();
+      bool                    built() const     { return _built; }
+      bool                    empty() const     { return _cells.empty(); }
+      rect                    bounds() const    { return _bounds; }
+
+      // The indices of the rects that may include p, in ascending order
+      range                   candidates(point p) const;
+
+   private:
+
+      rect                    _bounds;
+      rect                    _extent;
+      bool                    _built = false;
+      int                     _cols = 0;
+      int                     _rows = 0;
+      float                   _cell_width = 0;
+      float                   _cell_height = 0;
+      std::vector<index_type> _cells;     // Start of each cell in _items
+      std::vector<index_type> _items;
+   };
+}}
+
+#endif
@@ -0,0 +1,63 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_PIXMAP_CACHE_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_PIXMAP_CACHE_OCTOBER_16_2019
+
+#include <elements/support/pixmap.hpp>
+#include <list>
+#include <unordered_map>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // pixmap_cache
+   //
+   // Holds pixmaps rendered by elements (see cache_element) under a memory
+   // budget. Pixmaps are keyed by their owner. When the total exceeds the
+   // budget, the least recently used pixmaps are dropped; their owners
+   // simply render again the next time they draw.
+   ////////////////////////////////////////////////////////////////////////////
+   class pixmap_cache
+   {
+   public:
+
+      static constexpr std::size_t default_budget = 64 * 1024 * 1024;
+
+      explicit                pixmap_cache(std::size_t budget = default_budget)
+                               : _budget(budget)
+                              {}
+
+      pixmap_ptr              get(void const* key);
+      void                    put(void const* key, pixmap_ptr pm);
+      void                    erase(void const* key);
+      void                    clear();
+
+      std::size_t             budget() const                   { return _budget; }
+      void                    budget(std::size_t bytes);
+      std::size_t             size() const                     { return _size; }
+
+   private:
+
+      struct entry
+      {
+         void const*          key;
+         pixmap_ptr           pixmap;
+         std::size_t          bytes;
+      };
+
+      using entry_list = std::list<entry>;
+      using entry_map = std::unordered_map<void const*, entry_list::iterator>;
+
+      void                    evict();
+
+      entry_list              _entries;   // most recently used first
+      entry_map               _index;
+      std::size_t             _budget;
+      std::size_t             _size = 0;
+   };
+}}
+
+#endif
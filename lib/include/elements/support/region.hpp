@@ -0,0 +1,60 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_REGION_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_REGION_OCTOBER_16_2019
+
+#include <elements/support/rect.hpp>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // region
+   //
+   // A set of rects, typically the damaged area of a view. As rects are
+   // added, those that overlap or lie close together are merged when the
+   // pixels wasted by the union cost less than keeping them apart. The
+   // number of rects is capped at max_rects.
+   ////////////////////////////////////////////////////////////////////////////
+   class region
+   {
+   public:
+
+      using const_iterator = std::vector<rect>::const_iterator;
+
+      // Fixed cost of a rect, in pixels. Each rect costs a clip and a walk
+      // of the element tree, so we'd rather paint this many extra pixels
+      // than keep two rects apart.
+      static constexpr float        rect_cost = 64 * 64;
+      static constexpr std::size_t  max_rects = 16;
+
+                              region() {}
+                              region(rect r)                   { add(r); }
+
+      void                    add(rect r);
+      void                    add(region const& other);
+      void                    clear()                          { _rects.clear(); }
+
+      bool                    empty() const                    { return _rects.empty(); }
+      std::size_t             size() const                     { return _rects.size(); }
+      rect                    bounds() const;
+
+      const_iterator          begin() const                    { return _rects.begin(); }
+      const_iterator          end() const                      { return _rects.end(); }
+
+   private:
+
+      std::vector<rect>       _rects;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Free Functions
+   ////////////////////////////////////////////////////////////////////////////
+   bool                       intersects(rect a, region const& b);
+   region                     clip(region const& r, rect encl);
+}}
+
+#endif
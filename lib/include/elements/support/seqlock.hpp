@@ -0,0 +1,78 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_SEQLOCK_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_SEQLOCK_OCTOBER_16_2019
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // seqlock
+   //
+   // Shares a trivially copyable struct (e.g. several parameters of a DSP
+   // block) between one writer and any number of readers. The writer never
+   // waits, so it is safe to store from a real-time thread. Readers retry
+   // until they get a copy that was not torn by a concurrent store.
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   class seqlock
+   {
+   public:
+
+      static_assert(std::is_trivially_copyable<T>::value,
+         "seqlock requires a trivially copyable type");
+
+                              seqlock(T const& init = T{});
+
+      void                    store(T const& val);    // The writer only
+      T                       load() const;           // Any thread
+
+   private:
+
+      std::atomic<unsigned>   _seq{ 0 };
+      T                       _data;
+   };
+
+   ////////////////////////////////////////////////////////////////////////////
+   // Inlines
+   ////////////////////////////////////////////////////////////////////////////
+   template <typename T>
+   inline seqlock<T>::seqlock(T const& init)
+    : _data(init)
+   {}
+
+   template <typename T>
+   inline void seqlock<T>::store(T const& val)
+   {
+      // An odd sequence number tells readers a store is in progress
+      auto seq = _seq.load(std::memory_order_relaxed);
+      _seq.store(seq + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      std::memcpy(&_data, &val, sizeof(T));
+      _seq.store(seq + 2, std::memory_order_release);
+   }
+
+   template <typename T>
+   inline T seqlock<T>::load() const
+   {
+      T result;
+      for (;;)
+      {
+         auto seq = _seq.load(std::memory_order_acquire);
+         if (seq & 1)
+            continue;
+         std::memcpy(&result, &_data, sizeof(T));
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (_seq.load(std::memory_order_relaxed) == seq)
+            return result;
+      }
+   }
+}}
+
+#endif
@@ -0,0 +1,123 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_TEXT_BUFFER_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_TEXT_BUFFER_OCTOBER_16_2019
+
+#include <memory>
+#include <string>
+
+namespace cycfi { namespace elements
+{
+   namespace detail
+   {
+      struct paragraph_node;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // text_buffer
+   //
+   // UTF-8 text stored as a sequence of paragraphs, each one ending with
+   // its newline ('\n'), except the last, which has none and may be empty.
+   // Positions are byte offsets into the whole text, as if it were one
+   // contiguous string.
+   //
+   // The paragraphs are kept in a persistent balanced tree (a treap), each
+   // node holding the byte size and the number of paragraphs below it, so
+   // that positions map to paragraphs and back in O(log n). Nodes are
+   // immutable and shared: an edit copies only the O(log n) nodes on the
+   // path to the paragraphs it touches, and builds a new string for those
+   // paragraphs. Editing is O(paragraph + log n), even if the edit adds or
+   // removes newlines. Copying a buffer (e.g. for an undo state) copies
+   // the root and nothing else.
+   //
+   // str() flattens the text into one string, cached until the next edit.
+   //
+   // The buffer also tracks which paragraphs changed since the last call
+   // to clean(), so that layouts built on top of it (see static_text_box)
+   // can redo only the paragraphs that need it.
+   ////////////////////////////////////////////////////////////////////////////
+   class text_buffer
+   {
+   public:
+
+      using paragraph_ptr = std::shared_ptr<std::string const>;
+
+      // All paragraphs changed except the first head and the last tail
+      // paragraphs. If head + tail is at least the number of paragraphs,
+      // nothing changed.
+      struct damage
+      {
+         std::size_t          head;
+         std::size_t          tail;
+      };
+
+                              text_buffer(std::string const& text = "");
+                              text_buffer(text_buffer const& rhs);
+                              text_buffer(text_buffer&& rhs) = default;
+
+      text_buffer&            operator=(text_buffer const& rhs);
+      text_buffer&            operator=(text_buffer&& rhs) = default;
+
+      std::size_t             size() const                     { return _size; }
+      bool                    empty() const                    { return _size == 0; }
+      std::size_t             revision() const                 { return _revision; }
+
+      std::string const&      str() const;
+      std::string             substr(std::size_t pos, std::size_t n) const;
+
+      void                    assign(std::string const& text);
+      void                    insert(std::size_t pos, std::string const& s);
+      void                    erase(std::size_t pos, std::size_t n);
+      void                    replace(std::size_t pos, std::size_t n, std::string const& s);
+
+      // Paragraphs. Access by index is O(log n).
+      std::size_t             paragraphs() const;
+      std::string const&      paragraph(std::size_t i) const   { return *share(i); }
+      paragraph_ptr const&    share(std::size_t i) const;
+      std::size_t             paragraph_start(std::size_t i) const;
+      std::size_t             find_paragraph(std::size_t pos) const;
+
+      damage                  dirty() const                    { return _damage; }
+      void                    clean();
+
+      // UTF-8 cursors. at(pos) points into the paragraph holding pos and
+      // is valid until the next edit. UTF-8 sequences never straddle
+      // paragraphs, so the pointer can be decoded in place.
+      char const*             at(std::size_t pos) const;
+      unsigned                codepoint(std::size_t pos) const;
+      std::size_t             next(std::size_t pos) const;
+      std::size_t             prev(std::size_t pos) const;
+
+   private:
+
+      using node = detail::paragraph_node;
+      using node_ptr = std::shared_ptr<node const>;
+
+      // The paragraph holding pos, its index and where it starts
+      struct location
+      {
+         node const*          at;
+         std::size_t          index;
+         std::size_t          start;
+      };
+
+      location                locate(std::size_t pos) const;
+      void                    splice(
+                                 std::size_t pos, std::size_t n
+                               , char const* first, char const* last
+                              );
+      void                    changed(std::size_t head, std::size_t tail);
+
+      node_ptr                _root;
+      std::size_t             _size = 0;
+      std::size_t             _revision = 0;
+      damage                  _damage = { 0, 0 };
+      mutable std::string     _flat;
+      mutable bool            _flat_valid = false;
+   };
+}}
+
+#endif
@@ -67,6 +67,10 @@ namespace cycfi { namespace elements
 
    // Set the global theme
    void set_theme(theme const& thm);
+
+   // Bumped by set_theme. Anything rendered with the theme (e.g. cached
+   // pixmaps) is stale if it was rendered in another generation.
+   std::size_t theme_generation();
 }}
 
 #endif
@@ -0,0 +1,69 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_VALUE_QUEUE_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_VALUE_QUEUE_OCTOBER_16_2019
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace cycfi { namespace elements
+{
+   class element;
+
+   ////////////////////////////////////////////////////////////////////////////
+   // value_queue
+   //
+   // A bounded, lock-free, multiple producer, single consumer queue of
+   // element values. Producers (e.g. audio or network threads) push values;
+   // the UI thread pops them. The buffer is allocated once, up front, so
+   // push neither allocates nor blocks: it fails when the queue is full.
+   //
+   // This is the bounded queue of Dmitry Vyukov: each cell carries a
+   // sequence number that tells producers and the consumer whose turn it
+   // is to use the cell.
+   ////////////////////////////////////////////////////////////////////////////
+   class value_queue
+   {
+   public:
+
+      struct entry
+      {
+         enum kind_type { bool_, int_, double_ };
+
+         elements::element*   element;
+         kind_type            kind;
+         double               value;
+      };
+
+      // capacity is rounded up to a power of 2
+      explicit                value_queue(std::size_t capacity);
+
+                              value_queue(value_queue const&) = delete;
+      value_queue&            operator=(value_queue const&) = delete;
+
+      bool                    push(entry const& e);   // Any thread
+      bool                    pop(entry& e);          // The consumer only
+      std::size_t             capacity() const        { return _mask + 1; }
+
+   private:
+
+      struct cell
+      {
+         std::atomic<std::size_t>   seq;
+         entry                      data;
+      };
+
+      std::unique_ptr<cell[]> _cells;
+      std::size_t             _mask;
+
+      // Keep the producers' and consumer's indices on separate cache lines
+      alignas(64) std::atomic<std::size_t>   _tail{ 0 };
+      alignas(64) std::size_t                _head = 0;
+   };
+}}
+
+#endif
@@ -0,0 +1,61 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#if !defined(CYCFI_ELEMENTS_GUI_LIB_WORKER_POOL_OCTOBER_16_2019)
+#define CYCFI_ELEMENTS_GUI_LIB_WORKER_POOL_OCTOBER_16_2019
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // worker_pool
+   //
+   // A fixed set of long-lived threads that run one task at a time, all
+   // together. run(f) hands f to every worker, calls f on the calling
+   // thread as well, and returns when all of them are done. The task
+   // typically pulls work items off a shared atomic counter.
+   //
+   // The threads sleep between tasks, so a pool costs nothing while idle,
+   // and a task costs a wake-up per worker instead of a thread creation.
+   ////////////////////////////////////////////////////////////////////////////
+   class worker_pool
+   {
+   public:
+
+      using task = std::function<void()>;
+
+                              worker_pool() = default;
+                              ~worker_pool();
+
+                              worker_pool(worker_pool const&) = delete;
+      worker_pool&            operator=(worker_pool const&) = delete;
+
+      void                    workers(std::size_t n);
+      std::size_t             workers() const            { return _threads.size(); }
+      void                    run(task const& f);
+
+   private:
+
+      void                    stop();
+      void                    work(std::size_t epoch);
+
+      std::vector<std::thread> _threads;
+      std::mutex              _mutex;
+      std::condition_variable _start;
+      std::condition_variable _done;
+      task const*             _task = nullptr;
+      std::size_t             _epoch = 0;
+      std::size_t             _busy = 0;
+      bool                    _stop = false;
+   };
+}}
+
+#endif
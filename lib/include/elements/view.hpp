@@ -8,20 +8,32 @@
 
 #include <elements/base_view.hpp>
 #include <elements/support/rect.hpp>
+#include <elements/support/region.hpp>
+#include <elements/support/pixmap_cache.hpp>
+#include <elements/support/draw_profiler.hpp>
+#include <elements/support/event_trace.hpp>
+#include <elements/support/value_queue.hpp>
+#include <elements/support/seqlock.hpp>
+#include <elements/support/worker_pool.hpp>
 #include <elements/support/canvas.hpp>
 #include <elements/support/theme.hpp>
+#include <elements/support/detail/scratch_context.hpp>
 #include <elements/element/element.hpp>
 #include <elements/element/layer.hpp>
 #include <boost/asio.hpp>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <chrono>
+#include <thread>
 
 namespace cycfi { namespace elements
 {
    struct context;
    class window;
    class idle_tasks;
+   class cache_element;
 
    class view : public base_view
    {
@@ -42,9 +54,14 @@ namespace cycfi { namespace elements
 
       virtual void         refresh() override;
       virtual void         refresh(rect area) override;
+      // May be called from any thread. The element must outlive the call.
       void                 refresh(element& element);
       void                 refresh(context const& ctx);
-      rect                 dirty() const;
+      // The damage being drawn. On a draw thread (see parallel_draw), this
+      // is the damage within the tile the thread is drawing.
+      region const&        dirty() const;
+      void                 dirty(region const& area);
+      void                 update_bounds(element const& e, rect bounds);
 
       struct undo_redo_task
       {
@@ -70,9 +87,119 @@ namespace cycfi { namespace elements
       view_limits          limits() const;
       mouse_button         current_button() const;
 
+      // Pixmaps rendered by cache elements, shared under one memory budget.
+      // shared_cache() is for cache elements that may outlive the view.
+      pixmap_cache&        cache();
+      std::weak_ptr<pixmap_cache> shared_cache() const;
+
       using change_limits_function = std::function<void(view_limits limits_)>;
       change_limits_function on_change_limits;
 
+      // Called once per frame, before queued io work is run and before the
+      // frame is painted. Hosts drive frames from the display's frame
+      // clock where there is one, so this is the place to push values
+      // sampled from other threads (e.g. meters) at the display rate.
+      using frame_function = std::function<void(view& v)>;
+      frame_function       on_frame;
+
+      // Cross-thread value updates. Any thread, including real-time threads,
+      // may post a value for an element. Values are queued without locks or
+      // allocation, coalesced to the latest value per element, and applied
+      // on the UI thread once per frame, before drawing: the element gets
+      // the value through its value(val) overload, then is refreshed.
+      // post_value returns false if the queue is full. The element must
+      // outlive its pending updates.
+      bool                 post_value(element& e, bool val);
+      bool                 post_value(element& e, int val);
+      bool                 post_value(element& e, double val);
+
+      static constexpr std::size_t value_queue_capacity = 4096;
+
+      // Value bindings. Bind an element's value to a source written by
+      // another thread. The view samples each source once per frame, before
+      // drawing, and passes the value to the element through its value(val)
+      // overload, then refreshes it, but only if the value moved by more
+      // than epsilon since the last value passed on. A seqlock source is
+      // mapped to the element's value by f (T const& -> double). Bindings
+      // hold references: the element and source must outlive the binding,
+      // or call unbind(e) first.
+      static constexpr double default_epsilon = 1e-6;
+
+      void                 bind(element& e, std::atomic<double> const& src, double epsilon = default_epsilon);
+      void                 bind(element& e, std::atomic<float> const& src, double epsilon = default_epsilon);
+      void                 bind(element& e, std::atomic<int> const& src);
+      void                 bind(element& e, std::atomic<bool> const& src);
+
+                           template <typename T, typename F>
+      void                 bind(element& e, seqlock<T> const& src, F f, double epsilon = default_epsilon);
+
+      void                 unbind(element& e);
+
+      // The measured time between frames
+      using duration = std::chrono::duration<double>;
+      duration             frame_budget() const;
+
+      // Per-frame statistics. A frame runs from one draw to the next: the
+      // io work polled in between, then the limits, layout and draw of the
+      // frame itself. Counts are of the limits() and draw() calls composites
+      // make on their children, and of the children skipped because they
+      // lie outside the dirty region. dirty_area is the sum of the areas of
+      // the dirty rects, in pixels.
+      struct frame_stats
+      {
+         duration          io_time = {};
+         duration          limits_time = {};
+         duration          layout_time = {};
+         duration          draw_time = {};
+         std::size_t       limits_calls = 0;
+         std::size_t       draw_calls = 0;
+         std::size_t       culled = 0;
+         float             dirty_area = 0;
+      };
+
+      // The stats of the last frame drawn
+      frame_stats const&   stats() const;
+
+      // Called with the stats at the end of each frame
+      using stats_function = std::function<void(frame_stats const& stats)>;
+      stats_function       on_stats;
+
+      // Counters, called by the elements. These may be called from the
+      // draw threads (see parallel_draw).
+      void                 count_limits();
+      void                 count_draw();
+      void                 count_culled();
+
+      // Draw profiling. Pass a profiler to time the draw of each element,
+      // or nullptr (the default) to stop profiling. The view does not own
+      // the profiler.
+      void                 profiler(draw_profiler* p);
+      draw_profiler*       profiler() const;
+
+      // Input recording. Pass a trace to record the input events that reach
+      // the view, or nullptr (the default) to stop recording. The view does
+      // not own the trace.
+      void                 recorder(event_trace* trace);
+      event_trace*         recorder() const;
+
+      // Parallel drawing. With more than one thread, large damage regions
+      // are split into tiles, each drawn on a worker thread into its own
+      // image surface, then composited. This applies only if every element
+      // in the view supports concurrent_draw. The default is one thread.
+      // The worker threads are created on the first parallel draw and kept
+      // for the life of the view.
+      void                 parallel_draw(std::size_t threads);
+      std::size_t          parallel_draw() const;
+
+      // True while the tiles are being drawn. Elements must not fill their
+      // lazy caches (e.g. the limits cache of composites) then: several
+      // threads may be reading them.
+      bool                 drawing_tiles() const;
+
+      // Damage regions smaller than this (in pixels) are drawn directly
+      static constexpr float parallel_draw_min_area = 512 * 512;
+      static constexpr float parallel_draw_tile_size = 256;
+
       using io_context = boost::asio::io_context;
       io_context&          io();
 
@@ -87,18 +214,113 @@ namespace cycfi { namespace elements
       layer_composite      _content;
 
       bool                 set_limits();
+      bool                 find_bounds(element const& e, rect& bounds);
+      void                 clear_bounds();
+      void                 invalidate_caches();
+      void                 flush_damage();
+      void                 draw_tiled(cairo_t* context_, rect subj_bounds);
+      void                 end_frame();
+      void                 apply_values();
+      void                 poll_bindings();
 
-      bool                 _relayout = false;
-      rect                 _dirty;
+                           template <typename F>
+      void                 call(F f);
+
+      // Long-lived measurement context for limits and event dispatch. This
+      // spares us from creating a surface and a cairo context per event.
+      // It belongs to the UI thread (the thread that created the view);
+      // calls from other threads get a scratch context of their own.
+      detail::scratch_context _scratch;
+      canvas               _scratch_canvas;
+      std::thread::id      _ui_thread;
+
+      region               _dirty;
+
+      // Refresh requests are collected into a damage list and handed to
+      // the host once per io poll. _damage may be touched by any thread;
+      // _drawn_damage (what was handed to the host since the last draw)
+      // belongs to the UI thread.
+      std::mutex           _damage_mutex;
+      region               _damage;
+      bool                 _damage_all = false;
+      region               _drawn_damage;
+      bool                 _drawn_all = false;
       rect                 _current_bounds;
       view_limits          _current_limits = { { 0, 0 }, { full_extent, full_extent} };
       mouse_button         _current_button;
       bool                 _is_focus = false;
 
+      // Index of element to its last laid-out bounds, for refresh(element&).
+      // An element enters the index the first time it is refreshed (found
+      // by walking the tree, on the UI thread), and the index is kept up to
+      // date as elements are laid out. Any thread may look up the index,
+      // so it is guarded by _bounds_mutex. The index is dropped whenever
+      // the limits generation moves (e.g. children were added or removed),
+      // so that an element removed from the tree does not leave a stale
+      // entry behind for a new element at the same address.
+      //
+      // Each entry also lists the cache elements above the element. Their
+      // pixmaps hold the element's old image, so refreshing the element
+      // marks them stale. They are invalidated on the UI thread, before
+      // the next draw.
+      using cache_list = std::vector<cache_element*>;
+
+      struct bounds_entry
+      {
+         rect              bounds;
+         cache_list        caches;
+      };
+
+      using bounds_index = std::unordered_map<element const*, bounds_entry>;
+      std::mutex           _bounds_mutex;
+      bounds_index         _bounds_index;
+      std::size_t          _bounds_generation = 0;
+      cache_list           _stale_caches;
+      element const*       _refresh_target = nullptr;
+
       using undo_stack_type = std::stack<undo_redo_task>;
       undo_stack_type      _undo_stack;
       undo_stack_type      _redo_stack;
 
+      std::size_t          _draw_threads = 1;
+      worker_pool          _draw_pool;
+      bool                 _drawing_tiles = false;
+      std::shared_ptr<pixmap_cache> _cache = std::make_shared<pixmap_cache>();
+
+      using latest_values = std::unordered_map<element*, value_queue::entry>;
+      value_queue          _values{ value_queue_capacity };
+      latest_values        _latest_values;
+
+      struct binding
+      {
+         elements::element*         element;
+         value_queue::entry::kind_type kind;
+         std::function<double()>    load;
+         double                     epsilon;
+         double                     last;
+         bool                       applied;
+      };
+
+      void                 add_binding(
+                              element& e, value_queue::entry::kind_type kind
+                            , std::function<double()> load, double epsilon
+                           );
+
+      std::vector<binding> _bindings;
+
+      using clock = std::chrono::steady_clock;
+      clock::time_point    _last_frame;
+      duration             _frame_budget = duration{ 1.0 / 60 };
+
+      using counter = std::atomic<std::size_t>;
+      frame_stats          _stats;
+      frame_stats          _frame_stats;
+      counter              _limits_calls{ 0 };
+      counter              _draw_calls{ 0 };
+      counter              _culled{ 0 };
+      draw_profiler*       _profiler = nullptr;
+      event_trace*         _recorder = nullptr;
+
       io_context           _io;
       io_context::work     _work;
    };
@@ -106,9 +328,19 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    // Inlines
    ////////////////////////////////////////////////////////////////////////////
-   inline rect view::dirty() const
+   inline void view::dirty(region const& area)
+   {
+      _dirty = area;
+   }
+
+   inline pixmap_cache& view::cache()
+   {
+      return *_cache;
+   }
+
+   inline std::weak_ptr<pixmap_cache> view::shared_cache() const
    {
-      return _dirty;
+      return _cache;
    }
 
    inline bool view::has_undo()
@@ -140,7 +372,9 @@ namespace cycfi { namespace elements
          [e, this]
          {
             _content.push_back(e);
-            _relayout = true;
+            _content.invalidate_limits();
+            _content.layout_dirty(true);
+            e->layout_dirty(true);
             refresh(*e);
          }
       );
@@ -162,7 +396,9 @@ namespace cycfi { namespace elements
                refresh(*e);
                _content.erase(i);
                _content.reset();
-               _relayout = true;
+               _content.invalidate_limits();
+               clear_bounds();
+               _content.layout_dirty(true);
             }
          }
       );
@@ -173,6 +409,91 @@ namespace cycfi { namespace elements
       return _current_limits;
    }
 
+   inline view::duration view::frame_budget() const
+   {
+      return _frame_budget;
+   }
+
+   inline bool view::post_value(element& e, bool val)
+   {
+      return _values.push({ &e, value_queue::entry::bool_, double(val) });
+   }
+
+   inline bool view::post_value(element& e, int val)
+   {
+      return _values.push({ &e, value_queue::entry::int_, double(val) });
+   }
+
+   inline bool view::post_value(element& e, double val)
+   {
+      return _values.push({ &e, value_queue::entry::double_, val });
+   }
+
+   template <typename T, typename F>
+   inline void view::bind(element& e, seqlock<T> const& src, F f, double epsilon)
+   {
+      add_binding(
+         e, value_queue::entry::double_
+       , [&src, f]() { return double(f(src.load())); }
+       , epsilon
+      );
+   }
+
+   inline view::frame_stats const& view::stats() const
+   {
+      return _stats;
+   }
+
+   inline void view::count_limits()
+   {
+      _limits_calls.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   inline void view::count_draw()
+   {
+      _draw_calls.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   inline void view::count_culled()
+   {
+      _culled.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   inline void view::profiler(draw_profiler* p)
+   {
+      _profiler = p;
+   }
+
+   inline draw_profiler* view::profiler() const
+   {
+      return _profiler;
+   }
+
+   inline void view::recorder(event_trace* trace)
+   {
+      _recorder = trace;
+   }
+
+   inline event_trace* view::recorder() const
+   {
+      return _recorder;
+   }
+
+   inline void view::parallel_draw(std::size_t threads)
+   {
+      _draw_threads = std::max<std::size_t>(threads, 1);
+   }
+
+   inline std::size_t view::parallel_draw() const
+   {
+      return _draw_threads;
+   }
+
+   inline bool view::drawing_tiles() const
+   {
+      return _drawing_tiles;
+   }
+
    inline view::io_context& view::io()
    {
       return _io;
@@ -13,7 +13,7 @@
 # include <Windows.h>
 #endif
 
-#if defined(__linux__)
+#if defined(__linux__) && !defined(ELEMENTS_HOST_HEADLESS)
 # include <gtk/gtk.h>
 #endif
 
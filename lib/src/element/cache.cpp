@@ -0,0 +1,175 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/element/cache.hpp>
+#include <elements/support/context.hpp>
+#include <elements/view.hpp>
+#include <elements/support/theme.hpp>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      // The number of device pixels per user space unit
+      float device_scale(canvas& cnv)
+      {
+         auto& cr = cnv.cairo_context();
+         double scx = 1, scy = 1;
+         cairo_surface_get_device_scale(cairo_get_target(&cr), &scx, &scy);
+
+         cairo_matrix_t m;
+         cairo_get_matrix(&cr, &m);
+         auto ctm_scale = std::max(std::hypot(m.xx, m.yx), std::hypot(m.xy, m.yy));
+         return float(std::max(scx, scy) * ctm_scale);
+      }
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   // cache_element class implementation
+   ////////////////////////////////////////////////////////////////////////////
+   cache_element::~cache_element()
+   {
+      // Our pixmap is keyed by address. Don't leave it behind for the
+      // next cache element allocated at the same address.
+      if (auto cache = _cache.lock())
+         cache->erase(this);
+   }
+
+   void cache_element::draw(context const& ctx)
+   {
+      auto& cache = ctx.view.cache();
+      auto  scale = device_scale(ctx.canvas);
+
+      pixmap_ptr pm;
+      if (_valid
+         && _bounds == ctx.bounds
+         && _scale == scale
+         && _generation == theme_generation())
+         pm = cache.get(this);
+
+      if (!pm)
+      {
+         auto  w = ctx.bounds.width();
+         auto  h = ctx.bounds.height();
+         if (w <= 0 || h <= 0)
+            return;
+
+         pm = std::make_shared<pixmap>(
+            point{ std::ceil(w * scale), std::ceil(h * scale) }, 1 / scale
+         );
+
+         {
+            pixmap_context pm_ctx{ *pm };
+            canvas cnv{ *pm_ctx.context() };
+            cnv.translate({ -ctx.bounds.left, -ctx.bounds.top });
+
+            // Render the subject in full, whatever the view's dirty region
+            region dirty = ctx.view.dirty();
+            ctx.view.dirty(ctx.bounds);
+
+            context sctx{ ctx.view, cnv, &subject(), ctx.bounds };
+            sctx.parent = &ctx;
+            prepare_subject(sctx);
+            subject().draw(sctx);
+            restore_subject(sctx);
+
+            ctx.view.dirty(dirty);
+         }
+
+         cache.put(this, pm);
+         _cache = ctx.view.shared_cache();
+         _valid = true;
+         _bounds = ctx.bounds;
+         _scale = scale;
+         _generation = theme_generation();
+      }
+
+      ctx.canvas.draw(*pm, ctx.bounds);
+   }
+
+   void cache_element::layout(context const& ctx)
+   {
+      _valid = false;
+      proxy_base::layout(ctx);
+   }
+
+   void cache_element::refresh(context const& ctx, element& element)
+   {
+      if (&element == this)
+         _valid = false;
+      proxy_base::refresh(ctx, element);
+   }
+
+   bool cache_element::scroll(context const& ctx, point dir, point p)
+   {
+      bool r = proxy_base::scroll(ctx, dir, p);
+      if (r)
+         _valid = false;
+      return r;
+   }
+
+   element* cache_element::click(context const& ctx, mouse_button btn)
+   {
+      auto r = proxy_base::click(ctx, btn);
+      if (r)
+         _valid = false;
+      return r;
+   }
+
+   void cache_element::drag(context const& ctx, mouse_button btn)
+   {
+      _valid = false;
+      proxy_base::drag(ctx, btn);
+   }
+
+   bool cache_element::key(context const& ctx, key_info k)
+   {
+      bool r = proxy_base::key(ctx, k);
+      if (r)
+         _valid = false;
+      return r;
+   }
+
+   bool cache_element::text(context const& ctx, text_info info)
+   {
+      bool r = proxy_base::text(ctx, info);
+      if (r)
+         _valid = false;
+      return r;
+   }
+
+   bool cache_element::cursor(context const& ctx, point p, cursor_tracking status)
+   {
+      bool r = proxy_base::cursor(ctx, p, status);
+      if (r)
+         _valid = false;
+      return r;
+   }
+
+   void cache_element::value(bool val)
+   {
+      _valid = false;
+      proxy_base::value(val);
+   }
+
+   void cache_element::value(int val)
+   {
+      _valid = false;
+      proxy_base::value(val);
+   }
+
+   void cache_element::value(double val)
+   {
+      _valid = false;
+      proxy_base::value(val);
+   }
+
+   void cache_element::value(std::string val)
+   {
+      _valid = false;
+      proxy_base::value(val);
+   }
+}}
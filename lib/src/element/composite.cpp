@@ -40,11 +40,31 @@ namespace cycfi { namespace elements
          {
             auto& e = at(ix);
             context ectx{ ctx, &e, bounds };
+            draw_profiler::scope scope{ ctx.view.profiler(), e, bounds };
             e.draw(ectx);
+            ctx.view.count_draw();
+         }
+         else
+         {
+            ctx.view.count_culled();
          }
       }
    }
 
+   bool composite_base::concurrent_draw() const
+   {
+      // The view asks every frame. The answer can change only when the
+      // children change, and that is followed by a layout.
+      if (_concurrent_layout != _layout_count)
+      {
+         _concurrent = true;
+         for (std::size_t ix = 0; ix < size() && _concurrent; ++ix)
+            _concurrent = at(ix).concurrent_draw();
+         _concurrent_layout = _layout_count;
+      }
+      return _concurrent;
+   }
+
    void composite_base::refresh(context const& ctx, element& element)
    {
       if (&element == this)
@@ -207,6 +227,38 @@ namespace cycfi { namespace elements
          return true;
       }
 
+      // Fast path: while hovering within the bounds of the element we're
+      // tracking, and nothing was laid out since (see invalidate_cursor),
+      // that element is still the one under the cursor, provided its own
+      // hit_test agrees (it may not be rectangular) and, if children may
+      // overlap, no child above it covers the point. Skip the search for
+      // the child and send it the event directly. If it is a composite, it
+      // takes the same path, so small moves inside one control cost one
+      // check per level.
+      auto covered = [&]()
+      {
+         if (!overlapping())
+            return false;
+         for (auto ix = std::size_t(_cursor_info.index) + 1; ix < size(); ++ix)
+            if (bounds_of(ctx, ix).includes(p))
+               return true;
+         return false;
+      };
+
+      if (status == cursor_tracking::hovering
+         && _cursor_info.element
+         && _cursor_layout == _layout_count
+         && _cursor_info.bounds.includes(p)
+         && std::size_t(_cursor_info.index) < size()
+         && &at(_cursor_info.index) == _cursor_info.element
+         && bounds_of(ctx, _cursor_info.index) == _cursor_info.bounds
+         && !covered())
+      {
+         context ectx{ ctx, _cursor_info.element, _cursor_info.bounds };
+         if (_cursor_info.element->hit_test(ectx, p))
+            return _cursor_info.element->cursor(ectx, p, status);
+      }
+
       if (!empty())
       {
          hit_info info = hit_element(ctx, p);
@@ -221,6 +273,7 @@ namespace cycfi { namespace elements
                context ectx{ ctx, info.element, info.bounds };
                bool r = info.element->cursor(ectx, p, status);
                _cursor_info = info;
+               _cursor_layout = _layout_count;
                return r;
             }
          }
@@ -302,23 +355,64 @@ namespace cycfi { namespace elements
 
    composite_base::hit_info composite_base::hit_element(context const& ctx, point p) const
    {
+      if (_use_index)
+      {
+         for (auto ix : index(ctx).candidates(p))
+         {
+            auto info = hit_child(ctx, p, ix);
+            if (info.element)
+               return info;
+         }
+         return hit_info{ 0, rect{}, -1 };
+      }
+
       for (std::size_t ix = 0; ix < size(); ++ix)
       {
-         auto& e = at(ix);
-         if (e.is_control())
+         auto info = hit_child(ctx, p, ix);
+         if (info.element)
+            return info;
+      }
+      return hit_info{ 0, rect{}, -1 };
+   }
+
+   composite_base::hit_info
+   composite_base::hit_child(context const& ctx, point p, std::size_t index) const
+   {
+      auto& e = at(index);
+      if (e.is_control())
+      {
+         rect bounds = bounds_of(ctx, index);
+         if (bounds.includes(p))
          {
-            rect bounds = bounds_of(ctx, ix);
-            if (bounds.includes(p))
-            {
-               context ectx{ ctx, &e, bounds };
-               if (e.hit_test(ectx, p))
-                  return hit_info{ &e, bounds, int(ix) };
-            }
+            context ectx{ ctx, &e, bounds };
+            if (e.hit_test(ectx, p))
+               return hit_info{ &e, bounds, int(index) };
          }
       }
       return hit_info{ 0, rect{}, -1 };
    }
 
+   void composite_base::spatial_index(bool enable)
+   {
+      _use_index = enable;
+      _index.clear();
+   }
+
+   grid_index const& composite_base::index(context const& ctx) const
+   {
+      // The index is cleared by begin_layout. We also rebuild it if we are
+      // asked about other bounds, for composites that don't call
+      // begin_layout.
+      if (!_index.built() || _index.bounds() != ctx.bounds)
+      {
+         std::vector<rect> rects(size());
+         for (std::size_t ix = 0; ix != size(); ++ix)
+            rects[ix] = bounds_of(ctx, ix);
+         _index.build(ctx.bounds, rects);
+      }
+      return _index;
+   }
+
    bool composite_base::is_control() const
    {
       for (std::size_t ix = 0; ix < size(); ++ix)
@@ -335,4 +429,87 @@ namespace cycfi { namespace elements
       _click_info = hit_info{};
       _cursor_info = hit_info{};
    }
+
+   void composite_base::invalidate_cursor()
+   {
+      // The next cursor event takes the slow path and finds the element
+      // under the cursor again
+      _cursor_layout = -1;
+   }
+
+   void composite_base::invalidate_limits()
+   {
+      _limits_generation = 0;
+   }
+
+   bool composite_base::limits_cached() const
+   {
+      // Changing the children drops the cache (see composite). The child
+      // count is checked as well, in case the children changed behind our
+      // back.
+      return _limits_generation == limits_generation()
+         && _child_limits.size() == size();
+   }
+
+   view_limits composite_base::cache_limits(
+      basic_context const& ctx, view_limits limits_) const
+   {
+      // The cache is shared by all the draw threads (see view::drawing_tiles)
+      if (!ctx.view.drawing_tiles())
+      {
+         _limits = limits_;
+         _limits_generation = limits_generation();
+      }
+      return limits_;
+   }
+
+   view_limits composite_base::limits_of(basic_context const& ctx, std::size_t index) const
+   {
+      if (limits_cached())
+         return _child_limits[index];
+      ctx.view.count_limits();
+      if (ctx.view.drawing_tiles())
+         return at(index).limits(ctx);
+      if (_child_limits.size() != size())
+         _child_limits.resize(size());
+      return _child_limits[index] = at(index).limits(ctx);
+   }
+
+   bool composite_base::needs_layout(context const& ctx) const
+   {
+      return layout_dirty()
+         || ctx.bounds != _layout_bounds
+         || _layout_generation != limits_generation()
+         ;
+   }
+
+   bool composite_base::begin_layout(context const& ctx)
+   {
+      // Returns true if all the children must be laid out again. That is
+      // the case if our bounds changed or if any limits may have changed
+      // (see relimit_all).
+      bool all = ctx.bounds != _layout_bounds
+         || _layout_generation != limits_generation()
+         ;
+      _layout_bounds = ctx.bounds;
+      _layout_generation = limits_generation();
+      layout_dirty(false);
+      _index.clear();
+      ++_layout_count;
+      return all;
+   }
+
+   void composite_base::layout_child(
+      context const& ctx, element& e
+    , rect bounds, bool moved)
+   {
+      // The dirty bit is cleared before the child is laid out, so that the
+      // child (or its descendants) may mark it again while laying out.
+      if (moved || e.layout_dirty())
+      {
+         e.layout_dirty(false);
+         ctx.view.update_bounds(e, bounds);
+         e.layout(context{ ctx, &e, bounds });
+      }
+   }
 }}
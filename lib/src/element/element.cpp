@@ -6,9 +6,31 @@
 #include <elements/element/element.hpp>
 #include <elements/support.hpp>
 #include <elements/view.hpp>
+#include <atomic>
 
 namespace cycfi { namespace elements
 {
+   ////////////////////////////////////////////////////////////////////////////
+   // Limits cache generation
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      // Generation 0 is never current, so a default constructed cache
+      // stamp is always a miss. relimit_all may be called from any thread
+      // (e.g. a label whose text is set by a worker).
+      std::atomic<std::size_t> _limits_generation{ 1 };
+   }
+
+   void relimit_all()
+   {
+      _limits_generation.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   std::size_t limits_generation()
+   {
+      return _limits_generation.load(std::memory_order_relaxed);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // element class implementation
    ////////////////////////////////////////////////////////////////////////////
@@ -31,6 +53,11 @@ namespace cycfi { namespace elements
    {
    }
 
+   bool element::concurrent_draw() const
+   {
+      return false;
+   }
+
    void element::layout(context const& ctx)
    {
    }
@@ -90,6 +117,31 @@ namespace cycfi { namespace elements
       return false;
    }
 
+   void element::invalidate_limits()
+   {
+   }
+
+   void element::relimit(context const& ctx)
+   {
+      invalidate_limits();
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (p->element && p->element != this)
+            p->element->invalidate_limits();
+      }
+      relayout(ctx);
+   }
+
+   void element::relayout(context const& ctx)
+   {
+      _layout_dirty = true;
+      for (auto p = &ctx; p; p = p->parent)
+      {
+         if (p->element)
+            p->element->_layout_dirty = true;
+      }
+   }
+
    void element::value(bool val)
    {
    }
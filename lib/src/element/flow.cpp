@@ -21,10 +21,20 @@ namespace cycfi { namespace elements
 
    void flow_element::layout(context const& ctx)
    {
-      clear();
+      auto prev_height = _laid_out ? base_type::limits(ctx).min.y : -1;
+
+      // The rows are rebuilt on every layout. Clear them as a plain vector:
+      // only our own limits change, and we deal with that below.
+      base_type::container_type::clear();
+      invalidate_limits();
       _flowable.break_lines(*this, ctx, ctx.bounds.width());
       base_type::layout(ctx);
       _laid_out = true;
+
+      // Our minimum height depends on the number of rows. Let our
+      // ancestors know if that changed.
+      if (base_type::limits(ctx).min.y != prev_height)
+         relimit(ctx);
    }
 
    void flowable_container::break_lines(
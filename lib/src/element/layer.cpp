@@ -14,10 +14,13 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits layer_element::limits(basic_context const& ctx) const
    {
+      if (limits_cached())
+         return cached_limits();
+
       view_limits limits{ { 0.0, 0.0 }, { full_extent, full_extent } };
       for (std::size_t ix = 0; ix != size();  ++ix)
       {
-         auto el = at(ix).limits(ctx);
+         auto el = limits_of(ctx, ix);
 
          clamp_min(limits.min.x, el.min.x);
          clamp_min(limits.min.y, el.min.y);
@@ -28,44 +31,62 @@ namespace cycfi { namespace elements
          limits.max.y = std::max(limits.max.y, limits.min.y);
       }
 
-      return limits;
+      return cache_limits(ctx, limits);
    }
 
    void layer_element::layout(context const& ctx)
    {
+      // The bounds of each layer depend only on our bounds and its limits.
+      // A layer whose limits changed is marked dirty by relimit, so we lay
+      // out everything only if our bounds changed.
+      bool all = begin_layout(ctx);
       bounds = ctx.bounds;
+      _bounds.resize(size());
       for (std::size_t ix = 0; ix != size(); ++ix)
       {
-         auto& e = at(ix);
-         e.layout(context{ ctx, &e, bounds_of(ctx, ix) });
+         _bounds[ix] = child_bounds(ctx, ix);
+         layout_child(ctx, at(ix), _bounds[ix], all);
       }
    }
 
    layer_element::hit_info layer_element::hit_element(context const& ctx, point p) const
    {
       // we test from the highest index (topmost element)
-      for (int ix = int(size())-1; ix >= 0; --ix)
+      if (spatial_index())
       {
-         auto& e = at(ix);
-         if (e.is_control())
+         auto candidates = index(ctx).candidates(p);
+         for (auto i = candidates.end(); i != candidates.begin();)
          {
-            rect bounds = bounds_of(ctx, ix);
-            if (bounds.includes(p))
-            {
-               context ectx{ ctx, &e, bounds };
-               if (e.hit_test(ectx, p))
-                  return hit_info{ &e, bounds, int(ix) };
-            }
+            auto info = hit_child(ctx, p, *--i);
+            if (info.element)
+               return info;
          }
+         return hit_info{ 0, rect{}, -1 };
+      }
+
+      for (int ix = int(size())-1; ix >= 0; --ix)
+      {
+         auto info = hit_child(ctx, p, ix);
+         if (info.element)
+            return info;
       }
       return hit_info{ 0, rect{}, -1 };
    }
 
    rect layer_element::bounds_of(context const& ctx, std::size_t index) const
+   {
+      // Served from the bounds computed at layout time. Until we are laid
+      // out (or if children were added since), compute them.
+      if (_bounds.size() == size())
+         return _bounds[index];
+      return child_bounds(ctx, index);
+   }
+
+   rect layer_element::child_bounds(context const& ctx, std::size_t index) const
    {
       float width = ctx.bounds.width();
       float height = ctx.bounds.height();
-      auto  limits = at(index).limits(ctx);
+      auto  limits = limits_of(ctx, index);
 
       clamp_min(width, limits.min.x);
       clamp_max(width, limits.max.x);
@@ -109,7 +130,9 @@ namespace cycfi { namespace elements
       {
          auto& elem = at(_selected_index);
          context ectx{ ctx, &elem, bounds };
+         draw_profiler::scope scope{ ctx.view.profiler(), elem, bounds };
          elem.draw(ectx);
+         ctx.view.count_draw();
       }
    }
 
@@ -157,7 +180,10 @@ namespace cycfi { namespace elements
 
    void deck_element::select(std::size_t index)
    {
-      if (index < size())
+      if (index < size() && index != _selected_index)
+      {
          _selected_index = index;
+         invalidate_cursor();
+      }
    }
 }}
@@ -32,6 +32,7 @@ namespace cycfi { namespace elements
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
+      ctx.view.update_bounds(subject(), ctx.bounds);
       subject().layout(ctx);
    }
 
@@ -61,6 +62,7 @@ namespace cycfi { namespace elements
       ctx.bounds.top -= (elem_height - available_height) * _valign;
       ctx.bounds.height(elem_height);
 
+      ctx.view.update_bounds(subject(), ctx.bounds);
       subject().layout(ctx);
    }
 
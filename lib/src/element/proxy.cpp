@@ -35,14 +35,26 @@ namespace cycfi { namespace elements
    {
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
-      subject().draw(sctx);
+      {
+         draw_profiler::scope scope{ ctx.view.profiler(), subject(), sctx.bounds };
+         subject().draw(sctx);
+      }
       restore_subject(sctx);
    }
 
+   bool proxy_base::concurrent_draw() const
+   {
+      return subject().concurrent_draw();
+   }
+
    void proxy_base::layout(context const& ctx)
    {
+      // We are laid out only if we moved or if we (hence our subject) were
+      // marked dirty. Either way, the subject follows.
       context sctx { ctx, &subject(), ctx.bounds };
       prepare_subject(sctx);
+      subject().layout_dirty(false);
+      ctx.view.update_bounds(subject(), sctx.bounds);
       subject().layout(sctx);
       restore_subject(sctx);
    }
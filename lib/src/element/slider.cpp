@@ -15,7 +15,11 @@ namespace cycfi { namespace elements
       auto  limits_ = track().limits(ctx);
       auto  tmb_limits = thumb().limits(ctx);
 
-      if ((_is_horiz = limits_.max.x > limits_.max.y))
+      bool  is_horiz = limits_.max.x > limits_.max.y;
+      if (!ctx.view.drawing_tiles())
+         _is_horiz = is_horiz;
+
+      if (is_horiz)
       {
          limits_.min.y = std::max<float>(limits_.min.y, tmb_limits.min.y);
          limits_.max.y = std::max<float>(limits_.max.y, tmb_limits.max.y);
@@ -33,6 +37,11 @@ namespace cycfi { namespace elements
       return limits_;
    }
 
+   bool slider_base::concurrent_draw() const
+   {
+      return track().concurrent_draw() && thumb().concurrent_draw();
+   }
+
    void slider_base::layout(context const& ctx)
    {
       {
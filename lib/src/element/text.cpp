@@ -9,11 +9,20 @@
 #include <elements/support/text_utils.hpp>
 #include <elements/support/context.hpp>
 #include <elements/view.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
 
 namespace cycfi { namespace elements
 {
    using namespace std::chrono_literals;
 
+   namespace
+   {
+      char const empty_text[] = "";
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Static Text Box
    ////////////////////////////////////////////////////////////////////////////
@@ -25,14 +34,14 @@ namespace cycfi { namespace elements
     , int style
    )
     : _text(text)
-    , _layout(_text.data(), _text.data() + _text.size(), face, size, style)
+    , _layout(empty_text, empty_text, face, size, style)
     , _color(color_)
-   {}
+   {
+      sync(_wrap_width);
+   }
 
    view_limits static_text_box::limits(basic_context const& ctx) const
    {
-      sync();
-
       auto  size = _layout.metrics();
       auto  min_line_height = size.ascent + size.descent + size.leading;
       float line_height =
@@ -49,17 +58,17 @@ namespace cycfi { namespace elements
 
    void static_text_box::layout(context const& ctx)
    {
-      sync();
-
-      _rows.clear();
       auto  new_x = ctx.bounds.width();
-      _layout.break_lines(new_x, _rows);
+      sync(new_x);
       auto  size = _layout.metrics();
-      auto  new_y = _rows.size() * (size.ascent + size.descent + size.leading);
+      auto  new_y = num_rows() * (size.ascent + size.descent + size.leading);
 
-      // Refresh the whole view if the size has changed
+      // Refresh the whole view if the size has changed. Our limits track
+      // the height, so let our ancestors know if that changed.
       if (_current_size.x != new_x || _current_size.y != new_y)
          ctx.view.refresh();
+      if (_current_size.y != new_y)
+         relimit(ctx);
 
       _current_size.x = new_x;
       _current_size.y = new_y;
@@ -72,34 +81,153 @@ namespace cycfi { namespace elements
       auto  metrics = _layout.metrics();
       auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
       auto  x = ctx.bounds.left;
-      auto  y = ctx.bounds.top + metrics.ascent;
+      auto  top = ctx.bounds.top;
 
       cnv.rect(ctx.bounds);
       cnv.clip();
       cnv.fill_style(_color);
-      for (auto& row : _rows)
+
+      // Draw only the rows that intersect the dirty region, within the
+      // clip. All rows have the same height, so we find the rows under
+      // each dirty rect by division. We add a row on each side for glyphs
+      // that overflow their line.
+      using row_range = std::pair<std::size_t, std::size_t>;
+      std::vector<row_range> ranges;
+
+      auto  visible = cnv.clip_extent();
+      auto  add_range = [&](rect r)
       {
-         row.draw({ x, y }, cnv);
-         y += line_height;
-         if (y > ctx.bounds.bottom + metrics.ascent)
-            break;
+         r = clip(r, visible);
+         if (r.is_empty())
+            return;
+         auto first = std::max(std::floor((r.top - top) / line_height) - 1, 0.0f);
+         auto last = std::max(std::ceil((r.bottom - top) / line_height) + 1, 0.0f);
+         auto n = float(num_rows());
+         if (first < n)
+            ranges.push_back({ std::size_t(first), std::size_t(std::min(last, n)) });
+      };
+
+      auto const& dirty = ctx.view.dirty();
+      if (dirty.empty())
+         add_range(visible);
+      for (auto r : dirty)
+         add_range(r);
+
+      // Merge the ranges so that no row is drawn twice
+      std::sort(ranges.begin(), ranges.end());
+      std::size_t drawn = 0;
+      for (auto range : ranges)
+      {
+         auto first = std::max(range.first, drawn);
+         if (first >= range.second)
+            continue;
+
+         auto  i = paragraph_of_row(first);
+         auto  j = first - _paragraphs.first_row(i);
+         auto  y = top + metrics.ascent + (first * line_height);
+         for (auto row = first; row != range.second; ++row)
+         {
+            while (j == _paragraphs[i].rows.size())
+            {
+               ++i;
+               j = 0;
+            }
+            _paragraphs[i].rows[j++].draw({ x, y }, cnv);
+            y += line_height;
+         }
+         drawn = range.second;
       }
    }
 
-   void static_text_box::sync() const
+   void static_text_box::sync(float width)
    {
-      auto f = _text.data();
-      auto l = _text.data() + _text.size();
-      if (f != _layout.begin() || l != _layout.end())
-         _layout.text(f, l);
+      // Nothing to do if neither the text nor the width changed. The text
+      // may also change behind our back (e.g. an undo run by the view),
+      // so whoever reads the paragraphs syncs first.
+      if (width == _wrap_width && _text.revision() == _synced_revision)
+         return;
+
+      // Reshape the paragraphs that changed since the last sync
+      auto  damage = _text.dirty();
+      auto  old_size = _paragraphs.size();
+      auto  new_size = _text.paragraphs();
+      auto  head = std::min({ damage.head, old_size, new_size });
+      auto  tail = std::min({ damage.tail, old_size - head, new_size - head });
+      auto  old_last = old_size - tail;
+      auto  new_last = new_size - tail;
+      bool  rewrap = width != _wrap_width;
+      _wrap_width = width;
+
+      if (old_last == new_last)
+      {
+         // Same number of paragraphs: replace them in place
+         bool reindex = false;
+         for (auto i = head; i != new_last; ++i)
+         {
+            auto& para = _paragraphs[i];
+            auto  num_rows = para.rows.size();
+            para = shape(i);
+            wrap(para, width);
+            reindex = reindex || para.rows.size() != num_rows;
+         }
+         if (reindex && !rewrap)
+            _paragraphs.reindex(head, new_last);
+      }
+      else
+      {
+         paragraph_list::shaped_list shaped;
+         shaped.reserve(new_last - head);
+         for (auto i = head; i != new_last; ++i)
+         {
+            shaped.push_back(shape(i));
+            wrap(shaped.back(), width);
+         }
+         _paragraphs.replace(head, old_last, std::move(shaped));
+      }
+      _text.clean();
+      _synced_revision = _text.revision();
+
+      // Rewrap the rest if the width changed
+      if (rewrap)
+      {
+         for (std::size_t i = 0; i != _paragraphs.size(); ++i)
+         {
+            if (i < head || i >= new_last)
+               wrap(_paragraphs[i], width);
+         }
+         _paragraphs.reindex();
+      }
+   }
+
+   std::size_t static_text_box::paragraph_of_row(std::size_t row) const
+   {
+      return _paragraphs.find_row(row);
+   }
+
+   static_text_box::paragraph static_text_box::shape(std::size_t i) const
+   {
+      // Shape the paragraph without its newline
+      auto const& text = _text.share(i);
+      auto  first = text->data();
+      auto  last = first + text->size();
+      if (first != last && last[-1] == '\n')
+         --last;
+      return { text, master_glyphs{ first, last, _layout }, {} };
+   }
+
+   void static_text_box::wrap(paragraph& para, float width)
+   {
+      // No width yet: we will wrap on layout
+      para.rows.clear();
+      if (width < 0)
+         return;
+      para.layout.break_lines(width, para.rows);
    }
 
    void static_text_box::text(std::string const& text)
    {
-      _text = text;
-      _rows.clear();
-      _layout.text(_text.data(), _text.data() + _text.size());
-      _layout.break_lines(_current_size.x, _rows);
+      _text.assign(text);
+      sync(_wrap_width);
    }
 
    void static_text_box::value(std::string val)
@@ -107,6 +235,146 @@ namespace cycfi { namespace elements
       text(val);
    }
 
+   namespace
+   {
+      // Paragraphs per chunk of static_text_box::paragraph_list
+      constexpr std::size_t chunk_size = 256;
+   }
+
+   static_text_box::paragraph&
+   static_text_box::paragraph_list::operator[](std::size_t i)
+   {
+      auto loc = find(i);
+      return _chunks[loc.first].paragraphs[loc.second];
+   }
+
+   static_text_box::paragraph const&
+   static_text_box::paragraph_list::operator[](std::size_t i) const
+   {
+      auto loc = find(i);
+      return _chunks[loc.first].paragraphs[loc.second];
+   }
+
+   std::size_t static_text_box::paragraph_list::first_row(std::size_t i) const
+   {
+      if (_chunks.empty())
+         return 0;
+      auto loc = find(i);
+      return _first_row[loc.first] + _chunks[loc.first].first_row[loc.second];
+   }
+
+   std::size_t static_text_box::paragraph_list::find_row(std::size_t row) const
+   {
+      // The last paragraph that starts at or before row
+      auto it = std::upper_bound(_first_row.begin(), _first_row.end(), row);
+      auto c = std::size_t(it - _first_row.begin()) - 1;
+      if (c == _chunks.size())
+         return size();
+
+      auto const& rows = _chunks[c].first_row;
+      auto i = std::upper_bound(rows.begin(), rows.end(), row - _first_row[c]);
+      return _first[c] + std::size_t(i - rows.begin()) - 1;
+   }
+
+   void static_text_box::paragraph_list::replace(
+      std::size_t first, std::size_t last, shaped_list&& with
+   )
+   {
+      // Gather what is left of the chunks holding [first, last), with the
+      // new paragraphs in between, then cut that up into new chunks.
+      auto lo = find(first);
+      auto hi = find(last);
+      auto c1 = lo.first;
+      auto c2 = std::min(hi.first + 1, _chunks.size());
+
+      shaped_list items;
+      if (c1 == c2)
+      {
+         items = std::move(with);
+      }
+      else
+      {
+         auto& head = _chunks[c1].paragraphs;
+         auto& tail = _chunks[hi.first].paragraphs;
+         items.reserve(lo.second + with.size() + (tail.size() - hi.second));
+         std::move(head.begin(), head.begin() + lo.second, std::back_inserter(items));
+         std::move(with.begin(), with.end(), std::back_inserter(items));
+         std::move(tail.begin() + hi.second, tail.end(), std::back_inserter(items));
+      }
+
+      // Take in the next chunk too if we are left with too few
+      if (items.size() < chunk_size / 2 && c2 < _chunks.size())
+      {
+         auto& next = _chunks[c2++].paragraphs;
+         std::move(next.begin(), next.end(), std::back_inserter(items));
+      }
+
+      auto n = (items.size() + chunk_size - 1) / chunk_size;
+      std::vector<chunk> chunks(n);
+      for (std::size_t k = 0; k != n; ++k)
+      {
+         auto from = items.begin() + (k * items.size()) / n;
+         auto to = items.begin() + ((k + 1) * items.size()) / n;
+         auto& c = chunks[k];
+         c.paragraphs.reserve(to - from);
+         std::move(from, to, std::back_inserter(c.paragraphs));
+         index_chunk(c);
+      }
+
+      _chunks.erase(_chunks.begin() + c1, _chunks.begin() + c2);
+      _chunks.insert(
+         _chunks.begin() + c1
+       , std::make_move_iterator(chunks.begin())
+       , std::make_move_iterator(chunks.end())
+      );
+      index(c1);
+   }
+
+   void static_text_box::paragraph_list::reindex(std::size_t first, std::size_t last)
+   {
+      // The rows of the paragraphs in [first, last) changed
+      if (first >= last)
+         return;
+      auto c1 = find(first).first;
+      auto c2 = find(last - 1).first;
+      for (auto c = c1; c <= c2; ++c)
+         index_chunk(_chunks[c]);
+      index(c1);
+   }
+
+   static_text_box::paragraph_list::location
+   static_text_box::paragraph_list::find(std::size_t i) const
+   {
+      // The chunk holding paragraph i and where in it, or the end of the
+      // last chunk if i is the end.
+      auto it = std::upper_bound(_first.begin(), _first.end(), i);
+      auto c = std::size_t(it - _first.begin()) - 1;
+      if (c == _chunks.size() && c != 0)
+         --c;
+      return { c, i - _first[c] };
+   }
+
+   void static_text_box::paragraph_list::index_chunk(chunk& c)
+   {
+      auto n = c.paragraphs.size();
+      c.first_row.resize(n + 1);
+      c.first_row[0] = 0;
+      for (std::size_t i = 0; i != n; ++i)
+         c.first_row[i + 1] = c.first_row[i] + c.paragraphs[i].rows.size();
+   }
+
+   void static_text_box::paragraph_list::index(std::size_t first_chunk)
+   {
+      auto n = _chunks.size();
+      _first.resize(n + 1);
+      _first_row.resize(n + 1);
+      for (auto c = first_chunk; c < n; ++c)
+      {
+         _first[c + 1] = _first[c] + _chunks[c].paragraphs.size();
+         _first_row[c + 1] = _first_row[c] + _chunks[c].first_row.back();
+      }
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    // Editable Text Box
    ////////////////////////////////////////////////////////////////////////////
@@ -125,6 +393,7 @@ namespace cycfi { namespace elements
 
    void basic_text_box::draw(context const& ctx)
    {
+      sync(_wrap_width);
       draw_selection(ctx);
       static_text_box::draw(ctx);
       draw_caret(ctx);
@@ -144,38 +413,38 @@ namespace cycfi { namespace elements
          return this;
       }
 
-      char const*   _first = _text.data();
-      char const*   _last = _first + _text.size();
-
-      if (char const* pos = caret_position(ctx, btn.pos))
+      int pos = caret_position(ctx, btn.pos);
+      if (pos != -1)
       {
          if (btn.num_clicks != 1)
          {
-            char const* last = pos;
-            char const* first = pos;
+            std::size_t last = pos;
+            std::size_t first = pos;
 
             if (btn.num_clicks == 2)
             {
-               while (last < _last && !word_break(last))
-                  last = next_utf8(_last, last);
-               while (first > _first && !word_break(first))
-                  first = prev_utf8(_first, first);
+               while (last < _text.size() && !word_break(_text.at(last)))
+                  last = _text.next(last);
+               while (first > 0 && !word_break(_text.at(first)))
+                  first = _text.prev(first);
+               if (first != 0)
+                  first = _text.next(first);
             }
             else if (btn.num_clicks == 3)
             {
-               while (last < _last && !is_newline(uint8_t(*last)))
-                  last++;
-               while (first > _first && !is_newline(uint8_t(*first)))
-                  first--;
+               // Select the paragraph, without its newline
+               auto i = _text.find_paragraph(pos);
+               first = _text.paragraph_start(i);
+               last = first + _text.paragraph(i).size();
+               while (last > first && is_newline(uint8_t(*_text.at(last - 1))))
+                  --last;
             }
-            if (first != _first)
-                ++first;
-            _select_start = int(first - _first);
-            _select_end = int(last - _first);
+            _select_start = int(first);
+            _select_end = int(last);
          }
          else
          {
-            auto hit = int(pos - _first);
+            auto hit = pos;
             if ((btn.modifiers == mod_shift) && (_select_start != -1))
             {
                if (hit < _select_start)
@@ -196,10 +465,10 @@ namespace cycfi { namespace elements
 
    void basic_text_box::drag(context const& ctx, mouse_button btn)
    {
-      char const* first = &_text[0];
-      if (char const* pos = caret_position(ctx, btn.pos))
+      int pos = caret_position(ctx, btn.pos);
+      if (pos != -1)
       {
-         _select_end = int(pos-first);
+         _select_end = pos;
          _current_x = btn.pos.x-ctx.bounds.left;
          ctx.view.refresh(ctx);
       }
@@ -245,13 +514,12 @@ namespace cycfi { namespace elements
       if (!_typing_state)
          _typing_state = capture_state();
 
-      if (_select_start == _select_end)
-         _text.insert(_select_start, text);
-      else
-         _text.replace(_select_start, _select_end-_select_start, text);
-      _select_end = ++_select_start;
+      int start = std::min(_select_end, _select_start);
+      int end = std::max(_select_end, _select_start);
+      _text.replace(start, end-start, text);
+      _select_start = start + int(text.size());
+      _select_end = _select_start;
 
-      _layout.text(_text.data(), _text.data() + _text.size());
       layout(ctx);
 
       scroll_into_view(ctx, true);
@@ -281,20 +549,22 @@ namespace cycfi { namespace elements
 
       int start = std::min(_select_end, _select_start);
       int end = std::max(_select_end, _select_start);
-      std::function<void()> undo_f = capture_state();
+
+      // The state before the edit, captured only by the keys that edit
+      std::function<void()> undo_f;
 
       auto up_down = [this, &ctx, k, &move_caret]()
       {
          bool up = k.key == key_code::up;
          glyph_metrics info;
-         info = glyph_info(ctx, &_text[_select_end]);
+         info = glyph_info(ctx, _select_end);
          if (info.str)
          {
             auto y = up ? -info.line_height : +info.line_height;
             auto pos = point{ ctx.bounds.left + _current_x, info.pos.y + y };
-            char const* cp = caret_position(ctx, pos);
-            if (cp)
-               _select_end = int(cp - &_text[0]);
+            int cp = caret_position(ctx, pos);
+            if (cp != -1)
+               _select_end = cp;
             else
                _select_end = up ? 0 : int(_text.size());
             move_caret = true;
@@ -304,34 +574,42 @@ namespace cycfi { namespace elements
       auto next_char = [this]()
       {
          if (_select_end < _text.size())
-         {
-            char const* end = _text.data() + _text.size();
-            char const* p = next_utf8(end, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+            _select_end = int(_text.next(_select_end));
       };
 
       auto prev_char = [this]()
       {
          if (_select_end > 0)
-         {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
-            _select_end = int(p - &_text[0]);
-         }
+            _select_end = int(_text.prev(_select_end));
       };
 
+      // Words are scanned in place, one paragraph at a time. Newlines are
+      // word breaks, so only the breaks in between words can span
+      // paragraphs.
       auto next_word = [this]()
       {
          if (_select_end < _text.size())
          {
-            char const* p = &_text[_select_end];
-            char const* end = _text.data() + _text.size();
-            while (p != end && word_break(p))
-               p = next_utf8(end, p);
+            auto  i = _text.find_paragraph(_select_end);
+            auto  start = _text.paragraph_start(i);
+            auto  first = _text.paragraph(i).data();
+            auto  end = first + _text.paragraph(i).size();
+            auto  p = first + (_select_end - start);
+
+            while (true)
+            {
+               while (p != end && word_break(p))
+                  p = next_utf8(end, p);
+               if (p != end || i + 1 == _text.paragraphs())
+                  break;
+               start += end - first;
+               first = _text.paragraph(++i).data();
+               end = first + _text.paragraph(i).size();
+               p = first;
+            }
             while (p != end && !word_break(p))
                p = next_utf8(end, p);
-            _select_end = int(p - &_text[0]);
+            _select_end = int(start + (p - first));
          }
       };
 
@@ -339,15 +617,40 @@ namespace cycfi { namespace elements
       {
          if (_select_end > 0)
          {
-            char const* start = &_text[0];
-            char const* p = prev_utf8(start, &_text[_select_end]);
-            while (p != start && word_break(p))
-               p = prev_utf8(start, p);
-            while (p != start && !word_break(p))
-               p = prev_utf8(start, p);
-            char const* end = _text.data() + _text.size();
-            p = next_utf8(end, p);
-            _select_end = int(p - &_text[0]);
+            auto  i = _text.find_paragraph(_select_end);
+            auto  start = _text.paragraph_start(i);
+            auto  first = _text.paragraph(i).data();
+            auto  end = first + _text.paragraph(i).size();
+            auto  p = first + (_select_end - start);
+
+            auto  prev_paragraph = [&]()
+            {
+               first = _text.paragraph(--i).data();
+               end = first + _text.paragraph(i).size();
+               start -= end - first;
+               p = end - 1; // the newline
+            };
+
+            if (p == first)
+               prev_paragraph();
+            else
+               p = prev_utf8(first, p);
+
+            while (true)
+            {
+               while (p != first && word_break(p))
+                  p = prev_utf8(first, p);
+               if (p != first || i == 0 || !word_break(p))
+                  break;
+               prev_paragraph();
+            }
+            while (p != first && !word_break(p))
+               p = prev_utf8(first, p);
+
+            // The word starts after the break, if we stopped at one
+            if (word_break(p))
+               p = next_utf8(end, p);
+            _select_end = int(start + (p - first));
          }
       };
 
@@ -355,6 +658,7 @@ namespace cycfi { namespace elements
       {
          case key_code::enter:
             {
+               undo_f = capture_state();
                _text.replace(start, end-start, "\n");
                _select_start += 1;
                _select_end = _select_start;
@@ -367,6 +671,7 @@ namespace cycfi { namespace elements
          case key_code::backspace:
          case key_code::_delete:
             {
+               undo_f = capture_state();
                delete_();
                save_x = true;
                add_undo(ctx, _typing_state, undo_f, capture_state());
@@ -423,6 +728,7 @@ namespace cycfi { namespace elements
          case key_code::x:
             if (k.modifiers & mod_super)
             {
+               undo_f = capture_state();
                cut(ctx.view, start, end);
                save_x = true;
                add_undo(ctx, _typing_state, undo_f, capture_state());
@@ -441,6 +747,7 @@ namespace cycfi { namespace elements
          case key_code::v:
             if (k.modifiers & mod_super)
             {
+               undo_f = capture_state();
                paste(ctx.view, start, end);
                save_x = true;
                add_undo(ctx, _typing_state, undo_f, capture_state());
@@ -453,7 +760,7 @@ namespace cycfi { namespace elements
             {
                if (_typing_state)
                {
-                  ctx.view.add_undo({ _typing_state, undo_f });
+                  ctx.view.add_undo({ _typing_state, capture_state() });
                   _typing_state = {}; // reset
                }
 
@@ -478,7 +785,6 @@ namespace cycfi { namespace elements
       }
       else if (handled)
       {
-         _layout.text(_text.data(), _text.data() + _text.size());
          layout(ctx);
          ctx.view.refresh(ctx);
       }
@@ -527,7 +833,7 @@ namespace cycfi { namespace elements
       // Draw the caret
       else if (_is_focus && (_select_start != -1) && (_select_start == _select_end))
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, _select_start);
          auto width = theme.text_box_caret_width;
          rect& caret = start_info.bounds;
 
@@ -567,11 +873,11 @@ namespace cycfi { namespace elements
 
       if (!_text.empty())
       {
-         auto  start_info = glyph_info(ctx, _text.data() + _select_start);
+         auto  start_info = glyph_info(ctx, _select_start);
          rect& r1 = start_info.bounds;
          r1.right = ctx.bounds.right;
 
-         auto  end_info = glyph_info(ctx, _text.data() + _select_end);
+         auto  end_info = glyph_info(ctx, _select_end);
          rect& r2 = end_info.bounds;
          r2.right = r2.left;
          r2.left = ctx.bounds.left;
@@ -601,50 +907,39 @@ namespace cycfi { namespace elements
       }
    }
 
-   char const* basic_text_box::caret_position(context const& ctx, point p)
+   int basic_text_box::caret_position(context const& ctx, point p)
    {
+      sync(_wrap_width);
       auto  x = ctx.bounds.left;
       auto  y = ctx.bounds.top;
       auto  metrics = _layout.metrics();
       auto  line_height = metrics.ascent + metrics.descent + metrics.leading;
 
-      char const* found = nullptr;
-      for (auto& row : _rows)
-      {
-         // Check if p is within this row
-         if ((p.y >= y) && (p.y < y + line_height))
-         {
-            // Check if we are at the very start of the row
-            if (p.x == x)
-            {
-               found = row.begin();
-               break;
-            }
+      // Find the row at p.y. All rows have the same height.
+      if (p.y < y)
+         return -1;
+      auto  row = std::size_t((p.y - y) / line_height);
+      if (row >= num_rows())
+         return -1;
 
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [p, x, &found](char const* utf8, float left, float right)
-               {
-                  if ((p.x >= (x + left)) && (p.x < (x + right)))
-                  {
-                     found = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            // Assume it's at the end of the row if we haven't found a hit
-            if (!found)
-               found = row.end();
-            break;
-         }
-         y += line_height;
+      auto  i = paragraph_of_row(row);
+      auto& para = _paragraphs[i];
+      auto& row_ = para.rows[row - _paragraphs.first_row(i)];
+
+      // Check if we are at the very start of the row
+      char const* found = row_.begin();
+      if (p.x > x)
+      {
+         // Assume it's at the end of the row if we haven't found a hit
+         auto hit = row_.hit_test(p.x - x);
+         found = hit.utf8? hit.utf8 : row_.end();
       }
-      return found;
+      return int(_text.paragraph_start(i) + (found - para.text->data()));
    }
 
-   basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, char const* s)
+   basic_text_box::glyph_metrics basic_text_box::glyph_info(context const& ctx, int pos)
    {
+      sync(_wrap_width);
       auto  metrics = _layout.metrics();
       auto  x = ctx.bounds.left;
       auto  y = ctx.bounds.top + metrics.ascent;
@@ -657,56 +952,42 @@ namespace cycfi { namespace elements
       info.str = nullptr;
       info.line_height = line_height;
 
-      // Check if s is at the very end
-      if (s == _text.data() + _text.size())
-      {
-         auto const& last_row = _rows.back();
-         auto        rightmost = x + last_row.width();
-         auto        bottom_y = y + (line_height * (_rows.size() - 1));
-
-         info.pos = { rightmost, bottom_y };
-         info.bounds = { rightmost, bottom_y - ascent, rightmost + 10, bottom_y + descent };
-         info.str = s;
+      auto  i = _text.find_paragraph(pos);
+      if (i >= _paragraphs.size() || _paragraphs[i].rows.empty())
          return info;
-      }
 
-      glyphs*  prev_row = nullptr;
-      for (auto& row : _rows)
+      auto& para = _paragraphs[i];
+      auto& rows = para.rows;
+      char const* s = para.text->data() + (pos - _text.paragraph_start(i));
+
+      // Find the last row that starts at or before s
+      auto  it = std::upper_bound(rows.begin(), rows.end(), s,
+         [](char const* s, glyphs const& row) { return s < row.begin(); }
+      );
+      if (it != rows.begin())
+         --it;
+      auto& row = *it;
+      y += (_paragraphs.first_row(i) + (it - rows.begin())) * line_height;
+
+      // Get the actual coordinates of the glyph
+      if (s < row.end())
       {
-         // Check if s is within this row
-         if (s >= row.begin() && s < row.end())
-         {
-            // Get the actual coordinates of the glyph
-            row.for_each(
-               [s, &info, x, y, ascent, descent](char const* utf8, float left, float right)
-               {
-                  if (utf8 >= s)
-                  {
-                     info.pos = { x + left, y };
-                     info.bounds = { x + left, y - ascent, x + right, y + descent };
-                     info.str = utf8;
-                     return false;
-                  }
-                  return true;
-               }
-            );
-            break;
-         }
-         // This handles the case where s is in between the start of the
-         // current row and the end of the previous.
-         else if (s < row.begin() && prev_row)
+         auto c = row.locate(std::max(s, row.begin()));
+         if (c.utf8)
          {
-            auto  rightmost = x + prev_row->width();
-            auto  prev_y = y - line_height;
-            info.pos = { rightmost, prev_y };
-            info.bounds = { rightmost, prev_y - ascent, rightmost + 10, prev_y + descent };
-            info.str = s;
-            break;
+            info.pos = { x + c.left, y };
+            info.bounds = { x + c.left, y - ascent, x + c.right, y + descent };
+            info.str = c.utf8;
+            return info;
          }
-         y += line_height;
-         prev_row = &row;
       }
 
+      // s is at the end of the row: the end of the paragraph (its newline
+      // or the end of the text) or a space where the row was broken.
+      auto  rightmost = x + row.width();
+      info.pos = { rightmost, y };
+      info.bounds = { rightmost, y - ascent, rightmost + 10, y + descent };
+      info.str = s;
       return info;
    }
 
@@ -720,11 +1001,9 @@ namespace cycfi { namespace elements
          {
             if (start > 0)
             {
-               char const* start_p = &_text[0];
-               char const* end_p = &_text[start];
-               char const* p = prev_utf8(start_p, end_p);
-               start = int(p - &_text[0]);
-               _text.erase(start, end_p - p);
+               auto p = int(_text.prev(start));
+               _text.erase(p, start - p);
+               start = p;
             }
          }
          else
@@ -741,7 +1020,7 @@ namespace cycfi { namespace elements
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_text.substr(start_, end_-start_));
          delete_();
       }
    }
@@ -752,7 +1031,7 @@ namespace cycfi { namespace elements
       {
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
-         clipboard(_text.substr(start, end_-start_));
+         clipboard(_text.substr(start_, end_-start_));
       }
    }
 
@@ -763,9 +1042,9 @@ namespace cycfi { namespace elements
          auto  end_ = std::max(start, end);
          auto  start_ = std::min(start, end);
          std::string ins = clipboard();
-         _text.replace(start, end_-start_, ins);
-         start += ins.size();
-         _select_end = _select_start = start;
+         _text.replace(start_, end_-start_, ins);
+         start_ += ins.size();
+         _select_end = _select_start = start_;
       }
    }
 
@@ -787,11 +1066,11 @@ namespace cycfi { namespace elements
          select_end = save_select_end;
       }
 
-      std::string&   text;
+      text_buffer&   text;
       int&           select_start;
       int&           select_end;
 
-      std::string    save_text;
+      text_buffer    save_text;
       int            save_select_start;
       int            save_select_end;
    };
@@ -813,7 +1092,7 @@ namespace cycfi { namespace elements
       if (_select_end == -1)
          return;
 
-      auto info = glyph_info(ctx, &_text[_select_end]);
+      auto info = glyph_info(ctx, _select_end);
       if (info.str)
       {
          if (!scrollable::find(ctx).scroll_into_view(info.bounds.inset(-15, 0)))
@@ -891,7 +1170,7 @@ namespace cycfi { namespace elements
 
    void basic_input_box::draw(context const& ctx)
    {
-      if (text().empty())
+      if (_text.empty())
       {
          if (!_placeholder.empty())
          {
@@ -921,7 +1200,12 @@ namespace cycfi { namespace elements
    {
       bool r = basic_text_box::text(ctx, info);
       if (on_text)
-         text(on_text(text()));
+      {
+         // Reshape only if on_text changed the text
+         auto new_text = on_text(text());
+         if (new_text != text())
+            text(new_text);
+      }
       return r;
    }
 
@@ -996,8 +1280,8 @@ namespace cycfi { namespace elements
 
          if (on_text)
          {
-            auto new_text = on_text(_text);
-            if (new_text != _text)
+            auto new_text = on_text(text());
+            if (new_text != text())
             {
                text(new_text);
                select_all();
@@ -5,6 +5,7 @@
 =============================================================================*/
 #include <elements/element/tile.hpp>
 #include <elements/support/context.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
@@ -21,10 +22,13 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits vtile_element::limits(basic_context const& ctx) const
    {
+      if (limits_cached())
+         return cached_limits();
+
       view_limits limits{ { 0.0, 0.0 }, { full_extent, 0.0 } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = limits_of(ctx, i);
 
          limits.min.y += el.min.y;
          limits.max.y += el.max.y;
@@ -34,70 +38,110 @@ namespace cycfi { namespace elements
 
       clamp_min(limits.max.x, limits.min.x);
       clamp_max(limits.max.y, full_extent);
-      return limits;
+      return cache_limits(ctx, limits);
    }
 
    namespace
    {
-      // Compute the best fit for all elements
-      void allocate(
-         double size, double max_stretch, double total
-       , std::vector<layout_info>& info)
+      // Compute the best fit for all elements. Each element that can grow
+      // gets its minimum plus its stretch times a common factor, capped at
+      // its maximum:
+      //
+      //    alloc = min(max, min + factor * stretch)
+      //
+      // where factor is chosen so that the allocations fill the size. An
+      // element saturates (hits its max) when the factor reaches
+      // (max - min) / stretch. So we sort the elements by that ratio and
+      // saturate them in order until the remaining extra space, shared by
+      // the remaining stretch, no longer reaches the next ratio.
+      void allocate(double size, double total, std::vector<layout_info>& info)
       {
          double extra = size - total;
-         while (extra > 0.5)                    // loop while there's room to grow
+         if (extra <= 0)
+            return;
+
+         // The elements that can grow, and the total of their stretch
+         std::vector<std::size_t> growing;
+         double stretch = 0.0;
+         for (std::size_t i = 0; i != info.size(); ++i)
          {
-            double remove_stretch = 0.0;
-            total = 0.0;
-            for (auto& info : info)
+            if (info[i].alloc < info[i].max && info[i].stretch > 0)
             {
-               if (info.alloc < info.max)       // This element can grow
-               {
-                  info.alloc += extra * info.stretch / max_stretch;
-                  if (info.alloc >= info.max)   // We exceeded its max
-                  {
-                     info.alloc = info.max;
-                     remove_stretch -= info.stretch;
-                  }
-               }
-               total += info.alloc;
+               growing.push_back(i);
+               stretch += info[i].stretch;
+            }
+         }
+
+         auto saturation =
+            [&info](std::size_t i)
+            {
+               return (double(info[i].max) - info[i].min) / info[i].stretch;
+            };
+
+         std::sort(growing.begin(), growing.end(),
+            [&](std::size_t a, std::size_t b)
+            {
+               return saturation(a) < saturation(b);
+            }
+         );
+
+         // Saturate the elements that fill up before the rest
+         auto i = growing.begin();
+         for (; i != growing.end(); ++i)
+         {
+            if (extra < saturation(*i) * stretch)
+               break;
+            auto& e = info[*i];
+            extra -= double(e.max) - e.min;
+            stretch -= e.stretch;
+            e.alloc = e.max;
+         }
+
+         // The rest share what remains in proportion to their stretch
+         if (i != growing.end() && stretch > 0)
+         {
+            double factor = extra / stretch;
+            for (; i != growing.end(); ++i)
+            {
+               auto& e = info[*i];
+               e.alloc = e.min + factor * e.stretch;
             }
-            extra = size - total;
-            max_stretch -= remove_stretch;
          }
       }
    }
 
    void vtile_element::layout(context const& ctx)
    {
+      bool all = begin_layout(ctx);
       _left = ctx.bounds.left;
       _right = ctx.bounds.right;
-      _tiles.resize(size()+1);
+
+      // Keep the previous tiles around so we can tell which elements moved
+      std::vector<float> prev_tiles(size()+1);
+      prev_tiles.swap(_tiles);
+      all = all || prev_tiles.size() != _tiles.size();
 
       double const height = ctx.bounds.height();
 
-      // Collect min, max, and stretch information from each element. Also,
-      // accumulate the maximum stretch (max_stretch) for later. Initially set the
-      // allocation sizes of each element to its minimum.
-      double max_stretch = 0.0;
-      float total = 0.0;
+      // Collect min, max, and stretch information from each element.
+      // Initially set the allocation sizes of each element to its minimum.
+      double total = 0.0;
       std::vector<layout_info> info(size());
       for (std::size_t i = 0; i != size(); ++i)
       {
          auto& elem = at(i);
-         auto limits = elem.limits(ctx);
+         auto limits = limits_of(ctx, i);
          info[i].stretch = elem.stretch().y;
          total += (info[i].alloc = info[i].min = limits.min.y);
          info[i].max = limits.max.y;
-         if (info[i].alloc < info[i].max) // Can grow?
-            max_stretch += info[i].stretch;
       }
 
       // Compute the best fit for all elements
-      allocate(height, max_stretch, total, info);
+      allocate(height, total, info);
 
       // Now we have the final layout. We can now layout the individual
-      // elements.
+      // elements. Only elements that moved or asked for a relayout are laid
+      // out again.
       double curr = ctx.bounds.top;
       auto iter = _tiles.begin();
       std::size_t i = 0;
@@ -107,13 +151,39 @@ namespace cycfi { namespace elements
          auto prev = curr;
          curr += info.alloc;
 
+         bool moved = all
+            || prev_tiles[i] != float(prev)
+            || prev_tiles[i+1] != float(curr)
+            ;
          auto& elem = at(i++);
          rect ebounds = { _left, float(prev), _right, float(curr) };
-         elem.layout(context{ ctx, &elem, ebounds });
+         layout_child(ctx, elem, ebounds, moved);
       }
       *iter = curr;
    }
 
+   vtile_element::hit_info vtile_element::hit_element(context const& ctx, point p) const
+   {
+      if (_tiles.size() != size()+1)   // Not laid out yet
+         return composite_base::hit_element(ctx, p);
+
+      if (p.x < _left || p.x > _right)
+         return hit_info{ 0, rect{}, -1 };
+
+      // The tiles are sorted. Find the first tile that ends at or after p,
+      // then try it and any that follow and still include p (edges are
+      // shared, and tiles may be empty).
+      auto first = _tiles.begin() + 1;
+      std::size_t ix = std::lower_bound(first, _tiles.end(), p.y) - first;
+      for (; ix < size() && _tiles[ix] <= p.y; ++ix)
+      {
+         auto info = hit_child(ctx, p, ix);
+         if (info.element)
+            return info;
+      }
+      return hit_info{ 0, rect{}, -1 };
+   }
+
    rect vtile_element::bounds_of(context const& ctx, std::size_t index) const
    {
       return rect{ _left, _tiles[index], _right, _tiles[index+1] };
@@ -124,10 +194,13 @@ namespace cycfi { namespace elements
    ////////////////////////////////////////////////////////////////////////////
    view_limits htile_element::limits(basic_context const& ctx) const
    {
+      if (limits_cached())
+         return cached_limits();
+
       view_limits limits{ { 0.0, 0.0 }, { 0.0, full_extent } };
       for (std::size_t i = 0; i != size();  ++i)
       {
-         auto el = at(i).limits(ctx);
+         auto el = limits_of(ctx, i);
 
          limits.min.x += el.min.x;
          limits.max.x += el.max.x;
@@ -137,39 +210,41 @@ namespace cycfi { namespace elements
 
       clamp_min(limits.max.y, limits.min.y);
       clamp_max(limits.max.x, full_extent);
-      return limits;
+      return cache_limits(ctx, limits);
    }
 
    void htile_element::layout(context const& ctx)
    {
+      bool all = begin_layout(ctx);
       _top = ctx.bounds.top;
       _bottom = ctx.bounds.bottom;
-      _tiles.resize(size()+1);
+
+      // Keep the previous tiles around so we can tell which elements moved
+      std::vector<float> prev_tiles(size()+1);
+      prev_tiles.swap(_tiles);
+      all = all || prev_tiles.size() != _tiles.size();
 
       double const width = ctx.bounds.width();
 
-      // Collect min, max, and stretch information from each element. Also,
-      // accumulate the maximum stretch (max_stretch) for later. Initially
-      // set the allocation sizes of each element to its minimum.
-      double max_stretch = 0.0;
+      // Collect min, max, and stretch information from each element.
+      // Initially set the allocation sizes of each element to its minimum.
       double total = 0.0;
       std::vector<layout_info> info(size());
       for (std::size_t i = 0; i != size(); ++i)
       {
          auto& elem = at(i);
-         auto limits = elem.limits(ctx);
+         auto limits = limits_of(ctx, i);
          info[i].stretch = elem.stretch().x;
          total += (info[i].alloc = info[i].min = limits.min.x);
          info[i].max = limits.max.x;
-         if (info[i].alloc < info[i].max) // Can stretch?
-            max_stretch += info[i].stretch;
       }
 
       // Compute the best fit for all elements
-      allocate(width, max_stretch, total, info);
+      allocate(width, total, info);
 
       // Now we have the final layout. We can now layout the individual
-      // elements.
+      // elements. Only elements that moved or asked for a relayout are laid
+      // out again.
       double curr = ctx.bounds.left;
       auto iter = _tiles.begin();
       std::size_t i = 0;
@@ -179,13 +254,39 @@ namespace cycfi { namespace elements
          auto prev = curr;
          curr += info.alloc;
 
+         bool moved = all
+            || prev_tiles[i] != float(prev)
+            || prev_tiles[i+1] != float(curr)
+            ;
          auto& elem = at(i++);
          rect ebounds = { float(prev), _top, float(curr), _bottom };
-         elem.layout(context{ ctx, &elem, ebounds });
+         layout_child(ctx, elem, ebounds, moved);
       }
       *iter = curr;
    }
 
+   htile_element::hit_info htile_element::hit_element(context const& ctx, point p) const
+   {
+      if (_tiles.size() != size()+1)   // Not laid out yet
+         return composite_base::hit_element(ctx, p);
+
+      if (p.y < _top || p.y > _bottom)
+         return hit_info{ 0, rect{}, -1 };
+
+      // The tiles are sorted. Find the first tile that ends at or after p,
+      // then try it and any that follow and still include p (edges are
+      // shared, and tiles may be empty).
+      auto first = _tiles.begin() + 1;
+      std::size_t ix = std::lower_bound(first, _tiles.end(), p.x) - first;
+      for (; ix < size() && _tiles[ix] <= p.x; ++ix)
+      {
+         auto info = hit_child(ctx, p, ix);
+         if (info.element)
+            return info;
+      }
+      return hit_info{ 0, rect{}, -1 };
+   }
+
    rect htile_element::bounds_of(context const& ctx, std::size_t index) const
    {
       return rect{ _tiles[index], _top, _tiles[index + 1], _bottom };
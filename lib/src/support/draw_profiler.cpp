@@ -0,0 +1,132 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/draw_profiler.hpp>
+#include <elements/element/element.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <typeinfo>
+
+#if defined(__GNUC__)
+# include <cxxabi.h>
+#endif
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      std::string type_name(std::type_info const& info)
+      {
+#if defined(__GNUC__)
+         int status = 0;
+         char* name = abi::__cxa_demangle(info.name(), nullptr, nullptr, &status);
+         if (name && status == 0)
+         {
+            std::string result = name;
+            std::free(name);
+            return result;
+         }
+         std::free(name);
+#endif
+         return info.name();
+      }
+
+      void write_json_string(std::ostream& out, std::string const& s)
+      {
+         out << '"';
+         for (char c : s)
+         {
+            switch (c)
+            {
+               case '"':   out << "\\\""; break;
+               case '\\':  out << "\\\\"; break;
+               case '\b':  out << "\\b"; break;
+               case '\f':  out << "\\f"; break;
+               case '\n':  out << "\\n"; break;
+               case '\r':  out << "\\r"; break;
+               case '\t':  out << "\\t"; break;
+               default:
+                  // Other control characters must be escaped as well
+                  if (std::uint8_t(c) < 0x20)
+                  {
+                     char const* hex = "0123456789abcdef";
+                     out << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+                  }
+                  else
+                  {
+                     out << c;
+                  }
+                  break;
+            }
+         }
+         out << '"';
+      }
+   }
+
+   void draw_profiler::begin_frame()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _events.clear();
+      _frame_start = clock::now();
+   }
+
+   void draw_profiler::record(element const& e, rect bounds, clock::time_point start)
+   {
+      auto stop = clock::now();
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto i = _names.find(typeid(e));
+      if (i == _names.end())
+         i = _names.emplace(typeid(e), type_name(typeid(e))).first;
+      _events.push_back({ &i->second, bounds, start, stop, std::this_thread::get_id() });
+   }
+
+   std::vector<draw_profiler::event> draw_profiler::events() const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _events;
+   }
+
+   void draw_profiler::write_trace(std::ostream& out) const
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // Thread ids are opaque. Number the threads in order of appearance.
+      std::vector<std::thread::id> threads;
+      auto tid =
+         [&](std::thread::id id)
+         {
+            auto i = std::find(threads.begin(), threads.end(), id);
+            if (i == threads.end())
+               i = threads.insert(threads.end(), id);
+            return (i - threads.begin()) + 1;
+         };
+
+      using microseconds = std::chrono::duration<double, std::micro>;
+      out << "{\"traceEvents\":[";
+      bool first = true;
+      for (auto const& e : _events)
+      {
+         if (!first)
+            out << ',';
+         first = false;
+
+         out << "{\"name\":";
+         write_json_string(out, *e.name);
+         out << ",\"cat\":\"draw\",\"ph\":\"X\""
+            << ",\"ts\":" << microseconds(e.start - _frame_start).count()
+            << ",\"dur\":" << microseconds(e.stop - e.start).count()
+            << ",\"pid\":1,\"tid\":" << tid(e.thread)
+            << ",\"args\":{"
+            << "\"left\":" << e.bounds.left
+            << ",\"top\":" << e.bounds.top
+            << ",\"right\":" << e.bounds.right
+            << ",\"bottom\":" << e.bounds.bottom
+            << "}}";
+      }
+      out << "],\"displayTimeUnit\":\"ms\"}";
+   }
+}}
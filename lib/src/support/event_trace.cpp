@@ -0,0 +1,261 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/event_trace.hpp>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace cycfi { namespace elements
+{
+   ////////////////////////////////////////////////////////////////////////////
+   // Binary format
+   //
+   // The header is the magic "ELTR", a 16 bit version and a 32 bit event
+   // count. Each event follows as a 64 bit time in microseconds, the 8 bit
+   // kind, then a payload that depends on the kind:
+   //
+   //    click, drag:   down (8), num_clicks (8), state (8), modifiers (16),
+   //                   x, y (float)
+   //    cursor:        status (8), x, y (float)
+   //    scroll:        dx, dy, x, y (float)
+   //    key:           key (16), action (8), modifiers (16)
+   //    text:          codepoint (32), modifiers (16)
+   //
+   // Integers and floats are stored little endian.
+   ////////////////////////////////////////////////////////////////////////////
+   namespace
+   {
+      constexpr char          magic[4] = { 'E', 'L', 'T', 'R' };
+      constexpr std::uint16_t version = 1;
+
+      void put(std::ostream& out, std::uint64_t val, int bytes)
+      {
+         for (int i = 0; i != bytes; ++i)
+            out.put(char((val >> (i * 8)) & 0xff));
+      }
+
+      void put(std::ostream& out, float val)
+      {
+         std::uint32_t bits;
+         std::memcpy(&bits, &val, sizeof(bits));
+         put(out, bits, 4);
+      }
+
+      std::uint64_t get(std::istream& in, int bytes)
+      {
+         std::uint64_t val = 0;
+         for (int i = 0; i != bytes; ++i)
+         {
+            auto c = in.get();
+            if (c == std::istream::traits_type::eof())
+               throw failed_to_load_event_trace{ "Truncated event trace." };
+            val |= std::uint64_t(std::uint8_t(c)) << (i * 8);
+         }
+         return val;
+      }
+
+      float get_float(std::istream& in)
+      {
+         auto bits = std::uint32_t(get(in, 4));
+         float val;
+         std::memcpy(&val, &bits, sizeof(val));
+         return val;
+      }
+
+      // The smallest event: the time, the kind and a key payload
+      constexpr std::uint64_t min_event_size = 8 + 1 + 5;
+
+      // We reserve no more than this many events up front, whatever the
+      // header says. A larger trace simply grows as it loads.
+      constexpr std::uint64_t max_reserve = 64 * 1024;
+
+      // The number of bytes left in the stream, or -1 if the stream
+      // cannot tell (e.g. a pipe)
+      std::streamoff remaining(std::istream& in)
+      {
+         auto pos = in.tellg();
+         if (pos == std::streampos(-1))
+            return -1;
+         in.seekg(0, std::ios::end);
+         auto end = in.tellg();
+         in.clear();
+         in.seekg(pos);
+         return end == std::streampos(-1) ? -1 : std::streamoff(end - pos);
+      }
+   }
+
+   trace_event& event_trace::add(trace_event::kind_type kind)
+   {
+      auto now = clock::now();
+      if (_events.empty())
+         _start = now;
+
+      _events.push_back({});
+      auto& ev = _events.back();
+      ev.time = now - _start;
+      ev.kind = kind;
+      return ev;
+   }
+
+   void event_trace::record_click(mouse_button btn)
+   {
+      add(trace_event::click).button = btn;
+   }
+
+   void event_trace::record_drag(mouse_button btn)
+   {
+      add(trace_event::drag).button = btn;
+   }
+
+   void event_trace::record_cursor(point p, cursor_tracking status)
+   {
+      auto& ev = add(trace_event::cursor);
+      ev.pos = p;
+      ev.status = status;
+   }
+
+   void event_trace::record_scroll(point dir, point p)
+   {
+      auto& ev = add(trace_event::scroll);
+      ev.dir = dir;
+      ev.pos = p;
+   }
+
+   void event_trace::record_key(key_info const& k)
+   {
+      add(trace_event::key).key_ = k;
+   }
+
+   void event_trace::record_text(text_info const& info)
+   {
+      add(trace_event::text).text_ = info;
+   }
+
+   void event_trace::clear()
+   {
+      _events.clear();
+   }
+
+   void event_trace::save(std::ostream& out) const
+   {
+      using microseconds = std::chrono::duration<double, std::micro>;
+
+      out.write(magic, sizeof(magic));
+      put(out, version, 2);
+      put(out, _events.size(), 4);
+
+      for (auto const& ev : _events)
+      {
+         put(out, std::uint64_t(microseconds(ev.time).count()), 8);
+         put(out, ev.kind, 1);
+         switch (ev.kind)
+         {
+            case trace_event::click:
+            case trace_event::drag:
+               put(out, ev.button.down, 1);
+               put(out, ev.button.num_clicks, 1);
+               put(out, ev.button.state, 1);
+               put(out, ev.button.modifiers, 2);
+               put(out, ev.button.pos.x);
+               put(out, ev.button.pos.y);
+               break;
+
+            case trace_event::cursor:
+               put(out, int(ev.status), 1);
+               put(out, ev.pos.x);
+               put(out, ev.pos.y);
+               break;
+
+            case trace_event::scroll:
+               put(out, ev.dir.x);
+               put(out, ev.dir.y);
+               put(out, ev.pos.x);
+               put(out, ev.pos.y);
+               break;
+
+            case trace_event::key:
+               put(out, std::uint16_t(ev.key_.key), 2);
+               put(out, int(ev.key_.action), 1);
+               put(out, ev.key_.modifiers, 2);
+               break;
+
+            case trace_event::text:
+               put(out, ev.text_.codepoint, 4);
+               put(out, ev.text_.modifiers, 2);
+               break;
+         }
+      }
+   }
+
+   void event_trace::load(std::istream& in)
+   {
+      char header[sizeof(magic)];
+      if (!in.read(header, sizeof(header)) || std::memcmp(header, magic, sizeof(magic)) != 0)
+         throw failed_to_load_event_trace{ "Not an event trace." };
+      if (get(in, 2) != version)
+         throw failed_to_load_event_trace{ "Unsupported event trace version." };
+
+      // The count comes from the file, so it can't be trusted with an
+      // allocation. Check it against the size of the stream, if known.
+      auto count = get(in, 4);
+      auto left = remaining(in);
+      if (left >= 0 && count * min_event_size > std::uint64_t(left))
+         throw failed_to_load_event_trace{ "Truncated event trace." };
+
+      events_type events;
+      events.reserve(std::min(count, max_reserve));
+
+      using microseconds = std::chrono::duration<double, std::micro>;
+      for (std::uint64_t i = 0; i != count; ++i)
+      {
+         trace_event ev = {};
+         ev.time = microseconds(double(get(in, 8)));
+         ev.kind = trace_event::kind_type(get(in, 1));
+         switch (ev.kind)
+         {
+            case trace_event::click:
+            case trace_event::drag:
+               ev.button.down = get(in, 1) != 0;
+               ev.button.num_clicks = int(get(in, 1));
+               ev.button.state = mouse_button::what(get(in, 1));
+               ev.button.modifiers = int(get(in, 2));
+               ev.button.pos.x = get_float(in);
+               ev.button.pos.y = get_float(in);
+               break;
+
+            case trace_event::cursor:
+               ev.status = cursor_tracking(get(in, 1));
+               ev.pos.x = get_float(in);
+               ev.pos.y = get_float(in);
+               break;
+
+            case trace_event::scroll:
+               ev.dir.x = get_float(in);
+               ev.dir.y = get_float(in);
+               ev.pos.x = get_float(in);
+               ev.pos.y = get_float(in);
+               break;
+
+            case trace_event::key:
+               ev.key_.key = key_code(std::int16_t(get(in, 2)));
+               ev.key_.action = key_action(std::int8_t(get(in, 1)));
+               ev.key_.modifiers = int(get(in, 2));
+               break;
+
+            case trace_event::text:
+               ev.text_.codepoint = std::uint32_t(get(in, 4));
+               ev.text_.modifiers = int(get(in, 2));
+               break;
+
+            default:
+               throw failed_to_load_event_trace{ "Unknown event in event trace." };
+         }
+         events.push_back(ev);
+      }
+      _events = std::move(events);
+   }
+}}
@@ -5,11 +5,56 @@
 =============================================================================*/
 #include <elements/support/glyphs.hpp>
 #include <elements/support/detail/scratch_context.hpp>
+#include <algorithm>
 
 namespace cycfi { namespace elements
 {
    static detail::scratch_context scratch_context_;
 
+   namespace
+   {
+      // The first set bit in [first, last), or last if there is none
+      int find_next(std::vector<std::uint64_t> const& bits, int first, int last)
+      {
+         while (first < last)
+         {
+            auto word = bits[first / 64] >> (first % 64);
+            if (word)
+            {
+               while (!(word & 1))
+               {
+                  word >>= 1;
+                  ++first;
+               }
+               return std::min(first, last);
+            }
+            first = (first / 64 + 1) * 64;
+         }
+         return last;
+      }
+
+      // The last set bit in [first, last), or -1 if there is none
+      int find_prev(std::vector<std::uint64_t> const& bits, int first, int last)
+      {
+         while (last > first)
+         {
+            int i = last - 1;
+            auto word = bits[i / 64] << (63 - (i % 64));
+            if (word)
+            {
+               while (!(word >> 63))
+               {
+                  word <<= 1;
+                  --i;
+               }
+               return (i >= first)? i : -1;
+            }
+            last = (i / 64) * 64;
+         }
+         return -1;
+      }
+   }
+
    glyphs::glyphs(char const* first, char const* last)
     : _first(first)
     , _last(last)
@@ -33,6 +78,9 @@ namespace cycfi { namespace elements
     , _clusters(master._clusters + cluster_start)
     , _cluster_count(cluster_end - cluster_start)
     , _clusterflags(master._clusterflags)
+    , _lefts(master._left_x.data() + cluster_start)
+    , _rights(master._right_x.data() + cluster_start)
+    , _offsets(master._byte_start.data() + cluster_start)
    {
       CYCFI_ASSERT(_first, "Precondition failure: _first must not be null");
       CYCFI_ASSERT(_last, "Precondition failure: _last must not be null");
@@ -71,6 +119,9 @@ namespace cycfi { namespace elements
          _glyphs += glyph_index;
          _cluster_count -= clusters_skipped;
          _clusters = cluster;
+         _lefts += clusters_skipped;
+         _rights += clusters_skipped;
+         _offsets += clusters_skipped;
          _first += clusters_skipped;
       };
 
@@ -108,20 +159,50 @@ namespace cycfi { namespace elements
       if (_first == _last)
          return 0;
 
-      CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
-      CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
-      CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
+      CYCFI_ASSERT(_lefts, "Precondition failure: _lefts must not be null");
+      CYCFI_ASSERT(_rights, "Precondition failure: _rights must not be null");
 
-      if (_glyph_count)
-      {
-         cairo_text_extents_t extents;
-         auto glyph = _glyphs + _glyph_count -1;
-         cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-         return (glyph->x + extents.x_advance) - _glyphs->x;
-      }
+      if (_cluster_count)
+         return _rights[_cluster_count - 1] - _lefts[0];
       return 0;
    }
 
+   glyphs::cluster_info glyphs::hit_test(float x) const
+   {
+      if (_first == _last || _cluster_count == 0)
+         return { nullptr, 0, 0 };
+
+      // The first cluster that ends after x. The right edges never decrease.
+      float start_x = _lefts[0];
+      auto  i = std::upper_bound(_rights, _rights + _cluster_count, start_x + x) - _rights;
+      if (i == _cluster_count || (_lefts[i] - start_x) > x)
+         return { nullptr, 0, 0 };
+
+      return {
+         _first + (_offsets[i] - _offsets[0])
+       , _lefts[i] - start_x
+       , _rights[i] - start_x
+      };
+   }
+
+   glyphs::cluster_info glyphs::locate(char const* utf8) const
+   {
+      if (_first == _last || _cluster_count == 0)
+         return { nullptr, 0, 0 };
+
+      float start_x = _lefts[0];
+      int   offset = int(utf8 - _first) + _offsets[0];
+      auto  i = std::lower_bound(_offsets, _offsets + _cluster_count, offset) - _offsets;
+      if (i == _cluster_count)
+         return { nullptr, 0, 0 };
+
+      return {
+         _first + (_offsets[i] - _offsets[0])
+       , _lefts[i] - start_x
+       , _rights[i] - start_x
+      };
+   }
+
    glyphs::font_metrics glyphs::metrics() const
    {
       cairo_font_extents_t font_extents;
@@ -159,38 +240,58 @@ namespace cycfi { namespace elements
    master_glyphs::master_glyphs(master_glyphs&& rhs)
     : glyphs(rhs._first, rhs._last)
    {
-      _scaled_font = rhs._scaled_font;
-      _glyphs = rhs._glyphs;
-      _glyph_count = rhs._glyph_count;
-      _clusters = rhs._clusters;
-      _cluster_count = rhs._cluster_count;
-      _clusterflags = rhs._clusterflags;
-
-      rhs._glyphs = nullptr;
-      rhs._clusters = nullptr;
-      rhs._scaled_font = nullptr;
+      move(rhs);
    }
 
    master_glyphs& master_glyphs::operator=(master_glyphs&& rhs)
    {
       if (&rhs != this)
       {
+         if (_glyphs)
+            cairo_glyph_free(_glyphs);
+         if (_clusters)
+            cairo_text_cluster_free(_clusters);
+         if (_scaled_font)
+            cairo_scaled_font_destroy(_scaled_font);
+
          _first = rhs._first;
          _last = rhs._last;
-         _scaled_font = rhs._scaled_font;
-         _glyphs = rhs._glyphs;
-         _glyph_count = rhs._glyph_count;
-         _clusters = rhs._clusters;
-         _cluster_count = rhs._cluster_count;
-         _clusterflags = rhs._clusterflags;
-
-         rhs._glyphs = nullptr;
-         rhs._clusters = nullptr;
-         rhs._scaled_font = nullptr;
+         move(rhs);
       }
       return *this;
    }
 
+   void master_glyphs::move(master_glyphs& rhs)
+   {
+      _scaled_font = rhs._scaled_font;
+      _glyphs = rhs._glyphs;
+      _glyph_count = rhs._glyph_count;
+      _clusters = rhs._clusters;
+      _cluster_count = rhs._cluster_count;
+      _clusterflags = rhs._clusterflags;
+
+      // Moving the vectors keeps their storage, so _lefts and _rights
+      // (and those of the rows we broke) remain valid.
+      _left_x = std::move(rhs._left_x);
+      _right_x = std::move(rhs._right_x);
+      _glyph_start = std::move(rhs._glyph_start);
+      _byte_start = std::move(rhs._byte_start);
+      _spaces = std::move(rhs._spaces);
+      _newlines = std::move(rhs._newlines);
+      _lefts = rhs._lefts;
+      _rights = rhs._rights;
+      _offsets = rhs._offsets;
+
+      rhs._glyphs = nullptr;
+      rhs._glyph_count = 0;
+      rhs._clusters = nullptr;
+      rhs._cluster_count = 0;
+      rhs._scaled_font = nullptr;
+      rhs._lefts = nullptr;
+      rhs._rights = nullptr;
+      rhs._offsets = nullptr;
+   }
+
    master_glyphs::~master_glyphs()
    {
       if (_glyphs)
@@ -227,89 +328,79 @@ namespace cycfi { namespace elements
    {
       CYCFI_ASSERT(_scaled_font, "Precondition failure: _scaled_font must not be null");
 
-      // reurn early if there's nothing to break
+      // An empty text is a single empty line
       if (_first == _last)
+      {
+         glyphs empty{ _first, _last };
+         empty._scaled_font = _scaled_font;
+         lines.push_back(empty);
          return;
+      }
 
       CYCFI_ASSERT(_glyphs, "Precondition failure: _glyphs must not be null");
       CYCFI_ASSERT(_clusters, "Precondition failure: _clusters must not be null");
 
-      char const* first = _first;
-      char const* last = _last;
-      char const* space_pos = _first;
-      int         start_glyph_index = 0;
-      int         start_cluster_index = 0;
-      int         space_glyph_index = 0;
-      int         space_cluster_index = 0;
-      float       start_x = _glyphs->x;
-
-      auto add_line = [&]()
+      auto  first_line = lines.size();
+      auto  add_line = [&](int start, int end)
       {
          glyphs glyph_{
-            first, space_pos
-          , start_glyph_index, space_glyph_index
-          , start_cluster_index, space_cluster_index
+            _first + _byte_start[start], _first + _byte_start[end]
+          , _glyph_start[start], _glyph_start[end]
+          , start, end
           , *this
-          , lines.size() > 0 // skip leading spaces if this is not the first line
+          , lines.size() > first_line // skip leading spaces if this is not the first line
          };
          lines.push_back(std::move(glyph_));
-         first = space_pos;
-         start_glyph_index = space_glyph_index;
-         start_cluster_index = space_cluster_index;
-         start_x = _glyphs[space_glyph_index].x;
       };
 
-      int      glyph_index = 0;
-      unsigned codepoint;
-      unsigned state = 0;
-
-      cairo_text_cluster_t* cluster = _clusters;
-      for (auto i = _first; i != _last; ++i)
+      int   n = _cluster_count;
+      int   start = 0;
+      while (start < n)
       {
-         if (!decode_utf8(state, codepoint, uint8_t(*i)))
+         // Find the first cluster that does not fit. The right edges never
+         // decrease, so we can binary search.
+         auto  limit = _left_x[start] + width;
+         auto  i = std::upper_bound(_right_x.begin() + start, _right_x.end(), limit);
+         int   end = int(i - _right_x.begin());
+
+         // If we got an explicit new line before that, add the line right away.
+         int   nl = find_next(_newlines, start + 1, end);
+         if (nl != end)
          {
-            cairo_glyph_t*  glyph = _glyphs + glyph_index;
-
-            // Check if we exceeded the line width:
-            cairo_text_extents_t extents;
-            cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
-            if (((glyph->x + extents.x_advance) - start_x) > width)
-            {
-               // Add the line if we did (exceed the line width)
-               add_line();
-            }
-
-            // Did we have a space?
-            else if (is_space(codepoint))
-            {
-               // Mark the spaces for later
-               space_glyph_index = glyph_index;
-               space_cluster_index = int(cluster - _clusters);
-               space_pos = i;
-
-               // If we got an explicit new line, add the line right away.
-               if ((space_glyph_index != start_glyph_index) && is_newline(codepoint))
-                  add_line();
-            }
-
-            glyph_index += cluster->num_glyphs;
-            ++cluster;
+            add_line(start, nl);
+            start = nl;
+            continue;
          }
-      }
 
-      glyphs glyph_{
-         first, last
-       , start_glyph_index, _glyph_count
-       , start_cluster_index, _cluster_count
-       , *this
-       , lines.size() > 1 // skip leading spaces if this is not the first line
-      };
+         // Does the rest fit?
+         if (end == n)
+            break;
+
+         // Break at the last space, including the one that does not fit.
+         // If there is none, the word is wider than the line and we have
+         // to break it.
+         int   space = find_prev(_spaces, start + 1, end + 1);
+         int   break_ = (space != -1)? space : std::max(end, start + 1);
+         add_line(start, break_);
+         start = break_;
+      }
 
-      lines.push_back(std::move(glyph_));
+      if (start < n || lines.size() == first_line)
+         add_line(start, n);
    }
 
    void master_glyphs::build()
    {
+      _left_x.clear();
+      _right_x.clear();
+      _glyph_start.clear();
+      _byte_start.clear();
+      _spaces.clear();
+      _newlines.clear();
+      _lefts = _rights = nullptr;
+      _offsets = nullptr;
+      _glyph_count = _cluster_count = 0;
+
       // reurn early if there's nothing to build
       if (_first == _last)
          return;
@@ -323,7 +414,57 @@ namespace cycfi { namespace elements
       {
          _glyphs = nullptr;
          _clusters = nullptr;
+         _glyph_count = _cluster_count = 0;
          throw failed_to_build_master_glyphs{};
       }
+
+      // Measure the clusters once, here, rather than each time we break
+      // lines or hit test.
+      int n = _cluster_count;
+      _left_x.resize(n);
+      _right_x.resize(n);
+      _glyph_start.resize(n + 1);
+      _byte_start.resize(n + 1);
+      _spaces.assign((n + 63) / 64, 0);
+      _newlines.assign((n + 63) / 64, 0);
+
+      int   glyph_index = 0;
+      int   byte_index = 0;
+      float right = 0;
+      for (int i = 0; i != n; ++i)
+      {
+         _glyph_start[i] = glyph_index;
+         _byte_start[i] = byte_index;
+
+         float left = right;
+         float advance = 0;
+         if (glyph_index < _glyph_count)
+         {
+            cairo_text_extents_t extents;
+            cairo_glyph_t* glyph = _glyphs + glyph_index;
+            cairo_scaled_font_glyph_extents(_scaled_font, glyph, 1, &extents);
+            left = float(glyph->x);
+            advance = float(extents.x_advance);
+         }
+         right = (i == 0)? left + advance : std::max(right, left + advance);
+         _left_x[i] = left;
+         _right_x[i] = right;
+
+         char const* utf8 = _first + byte_index;
+         auto cp = codepoint(utf8);
+         if (is_space(cp))
+            _spaces[i / 64] |= std::uint64_t(1) << (i % 64);
+         if (is_newline(cp))
+            _newlines[i / 64] |= std::uint64_t(1) << (i % 64);
+
+         glyph_index += _clusters[i].num_glyphs;
+         byte_index += _clusters[i].num_bytes;
+      }
+      _glyph_start[n] = glyph_index;
+      _byte_start[n] = byte_index;
+
+      _lefts = _left_x.data();
+      _rights = _right_x.data();
+      _offsets = _byte_start.data();
    }
 }}
@@ -0,0 +1,95 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/grid_index.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   void grid_index::build(rect bounds, std::vector<rect> const& rects)
+   {
+      clear();
+      _bounds = bounds;
+      _built = true;
+      if (rects.empty())
+         return;
+
+      // The grid spans the bounds and all the rects
+      _extent = bounds;
+      for (auto const& r : rects)
+         if (is_valid(r))
+            _extent = max(_extent, r);
+
+      // About one cell per rect, shaped after the extent. A degenerate
+      // extent still gets cells of some size.
+      auto n = float(rects.size());
+      auto width = std::max(_extent.width(), 1.0f);
+      auto height = std::max(_extent.height(), 1.0f);
+      _cols = std::max(1, int(std::round(std::sqrt(n * width / height))));
+      _rows = std::max(1, int(std::round(n / _cols)));
+      _cell_width = width / _cols;
+      _cell_height = height / _rows;
+
+      // The range of cells a rect overlaps (inclusive)
+      auto cell_range =
+         [this](rect r, int& c1, int& r1, int& c2, int& r2)
+         {
+            c1 = std::clamp(int((r.left - _extent.left) / _cell_width), 0, _cols-1);
+            c2 = std::clamp(int((r.right - _extent.left) / _cell_width), 0, _cols-1);
+            r1 = std::clamp(int((r.top - _extent.top) / _cell_height), 0, _rows-1);
+            r2 = std::clamp(int((r.bottom - _extent.top) / _cell_height), 0, _rows-1);
+            return is_valid(r);
+         };
+
+      // Two passes: count the items per cell, then fill them in
+      std::vector<index_type> counts(_cols * _rows + 1, 0);
+      for (auto const& r : rects)
+      {
+         int c1, r1, c2, r2;
+         if (cell_range(r, c1, r1, c2, r2))
+            for (int y = r1; y <= r2; ++y)
+               for (int x = c1; x <= c2; ++x)
+                  ++counts[y * _cols + x + 1];
+      }
+
+      _cells.resize(counts.size());
+      for (std::size_t i = 1; i < counts.size(); ++i)
+         counts[i] += counts[i-1];
+      std::copy(counts.begin(), counts.end(), _cells.begin());
+      _items.resize(counts.back());
+
+      for (index_type i = 0; i != rects.size(); ++i)
+      {
+         int c1, r1, c2, r2;
+         if (cell_range(rects[i], c1, r1, c2, r2))
+            for (int y = r1; y <= r2; ++y)
+               for (int x = c1; x <= c2; ++x)
+                  _items[counts[y * _cols + x]++] = i;
+      }
+   }
+
+   void grid_index::clear()
+   {
+      _bounds = {};
+      _extent = {};
+      _built = false;
+      _cols = _rows = 0;
+      _cells.clear();
+      _items.clear();
+   }
+
+   grid_index::range grid_index::candidates(point p) const
+   {
+      if (_cells.empty() || !_extent.includes(p))
+         return { nullptr, nullptr };
+
+      int col = std::min(int((p.x - _extent.left) / _cell_width), _cols-1);
+      int row = std::min(int((p.y - _extent.top) / _cell_height), _rows-1);
+      auto cell = row * _cols + col;
+      auto items = _items.data();
+      return { items + _cells[cell], items + _cells[cell+1] };
+   }
+}}
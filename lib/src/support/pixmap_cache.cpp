@@ -0,0 +1,82 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/pixmap_cache.hpp>
+#include <cmath>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      std::size_t bytes_of(pixmap const& pm)
+      {
+         auto size = pm.size();
+         auto scale = pm.scale();
+         return std::size_t(std::ceil(size.x / scale))
+            * std::size_t(std::ceil(size.y / scale)) * 4;
+      }
+   }
+
+   pixmap_ptr pixmap_cache::get(void const* key)
+   {
+      auto i = _index.find(key);
+      if (i == _index.end())
+         return {};
+
+      // Move to the front: most recently used
+      _entries.splice(_entries.begin(), _entries, i->second);
+      return i->second->pixmap;
+   }
+
+   void pixmap_cache::put(void const* key, pixmap_ptr pm)
+   {
+      erase(key);
+      if (!pm)
+         return;
+
+      auto bytes = bytes_of(*pm);
+      _entries.push_front({ key, pm, bytes });
+      _index[key] = _entries.begin();
+      _size += bytes;
+      evict();
+   }
+
+   void pixmap_cache::erase(void const* key)
+   {
+      auto i = _index.find(key);
+      if (i != _index.end())
+      {
+         _size -= i->second->bytes;
+         _entries.erase(i->second);
+         _index.erase(i);
+      }
+   }
+
+   void pixmap_cache::clear()
+   {
+      _entries.clear();
+      _index.clear();
+      _size = 0;
+   }
+
+   void pixmap_cache::budget(std::size_t bytes)
+   {
+      _budget = bytes;
+      evict();
+   }
+
+   void pixmap_cache::evict()
+   {
+      // Drop the least recently used pixmaps until we're within budget, but
+      // always keep the most recent one, even if it alone is over budget.
+      while (_size > _budget && _entries.size() > 1)
+      {
+         auto& last = _entries.back();
+         _size -= last.bytes;
+         _index.erase(last.key);
+         _entries.pop_back();
+      }
+   }
+}}
@@ -0,0 +1,103 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/region.hpp>
+#include <limits>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      // The number of pixels we'd paint needlessly if a and b were merged
+      float merge_waste(rect a, rect b)
+      {
+         float covered = area(a) + area(b);
+         if (intersects(a, b))
+            covered -= area(min(a, b));
+         return area(max(a, b)) - covered;
+      }
+   }
+
+   void region::add(rect r)
+   {
+      if (!is_valid(r) || r.is_empty())
+         return;
+
+      // Merge r with the rects it is cheaper to merge with than to keep
+      // apart. Each merge grows r, so we start over until no more merges
+      // are possible.
+      for (bool merged = true; merged;)
+      {
+         merged = false;
+         for (auto i = _rects.begin(); i != _rects.end(); ++i)
+         {
+            if (i->includes(r))
+               return;
+
+            if (merge_waste(*i, r) <= rect_cost)
+            {
+               r = max(*i, r);
+               _rects.erase(i);
+               merged = true;
+               break;
+            }
+         }
+      }
+
+      if (_rects.size() < max_rects)
+      {
+         _rects.push_back(r);
+         return;
+      }
+
+      // We're full. Merge r with the rect that wastes the least.
+      auto  best = _rects.begin();
+      float least = std::numeric_limits<float>::max();
+      for (auto i = _rects.begin(); i != _rects.end(); ++i)
+      {
+         float waste = merge_waste(*i, r);
+         if (waste < least)
+         {
+            least = waste;
+            best = i;
+         }
+      }
+      r = max(*best, r);
+      _rects.erase(best);
+      add(r);
+   }
+
+   void region::add(region const& other)
+   {
+      for (auto const& r : other)
+         add(r);
+   }
+
+   rect region::bounds() const
+   {
+      if (_rects.empty())
+         return {};
+      rect r = _rects.front();
+      for (auto const& e : _rects)
+         r = max(r, e);
+      return r;
+   }
+
+   bool intersects(rect a, region const& b)
+   {
+      for (auto const& r : b)
+         if (intersects(a, r))
+            return true;
+      return false;
+   }
+
+   region clip(region const& r, rect encl)
+   {
+      region result;
+      for (auto const& e : r)
+         result.add(clip(e, encl));
+      return result;
+   }
+}}
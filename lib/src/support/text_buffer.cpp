@@ -0,0 +1,535 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/text_buffer.hpp>
+#include <elements/support/text_utils.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace cycfi { namespace elements
+{
+   namespace detail
+   {
+      using paragraph_ptr = text_buffer::paragraph_ptr;
+      using node_ptr = std::shared_ptr<paragraph_node const>;
+
+      // A node of the paragraph treap: one paragraph, its subtrees, and the
+      // byte size and the number of paragraphs of the whole subtree. Nodes
+      // are immutable, so subtrees can be shared between buffers.
+      struct paragraph_node
+      {
+         paragraph_node(
+            paragraph_ptr text_, node_ptr left_, node_ptr right_
+          , std::uint32_t priority_
+         );
+
+         paragraph_ptr        text;
+         node_ptr             left;
+         node_ptr             right;
+         std::size_t          size;
+         std::size_t          count;
+         std::uint32_t        priority;
+      };
+   }
+
+   namespace
+   {
+      using node = detail::paragraph_node;
+      using node_ptr = detail::node_ptr;
+      using paragraph_ptr = text_buffer::paragraph_ptr;
+      using paragraph_list = std::vector<paragraph_ptr>;
+
+      std::size_t size_of(node_ptr const& t)
+      {
+         return t? t->size : 0;
+      }
+
+      std::size_t count_of(node_ptr const& t)
+      {
+         return t? t->count : 0;
+      }
+
+      // Treap priorities: a hash of a counter, which is as good as random
+      // for balancing, and cheap.
+      std::uint32_t new_priority()
+      {
+         static std::atomic<std::uint32_t> counter{ 0 };
+         auto x = counter.fetch_add(1, std::memory_order_relaxed);
+         x ^= x >> 16;
+         x *= 0x7feb352d;
+         x ^= x >> 15;
+         x *= 0x846ca68b;
+         x ^= x >> 16;
+         return x;
+      }
+
+      node_ptr make_node(
+         paragraph_ptr text, node_ptr left, node_ptr right
+       , std::uint32_t priority
+      )
+      {
+         return std::make_shared<node const>(
+            std::move(text), std::move(left), std::move(right), priority);
+      }
+
+      // A copy of t with other children
+      node_ptr with_children(node const& t, node_ptr left, node_ptr right)
+      {
+         return make_node(t.text, std::move(left), std::move(right), t.priority);
+      }
+
+      // Concatenate a and b. Returns a new root; a and b are untouched.
+      node_ptr merge(node_ptr const& a, node_ptr const& b)
+      {
+         if (!a)
+            return b;
+         if (!b)
+            return a;
+         if (a->priority > b->priority)
+            return with_children(*a, a->left, merge(a->right, b));
+         return with_children(*b, merge(a, b->left), b->right);
+      }
+
+      // Split t into the first k paragraphs and the rest
+      std::pair<node_ptr, node_ptr> split(node_ptr const& t, std::size_t k)
+      {
+         if (!t)
+            return {};
+         auto lc = count_of(t->left);
+         if (k <= lc)
+         {
+            auto parts = split(t->left, k);
+            return { parts.first, with_children(*t, parts.second, t->right) };
+         }
+         auto parts = split(t->right, k - lc - 1);
+         return { with_children(*t, t->left, parts.first), parts.second };
+      }
+
+      // A copy of t with paragraph i replaced by text
+      node_ptr replace(node_ptr const& t, std::size_t i, paragraph_ptr text)
+      {
+         auto lc = count_of(t->left);
+         if (i < lc)
+            return with_children(*t, replace(t->left, i, std::move(text)), t->right);
+         if (i > lc)
+            return with_children(*t, t->left, replace(t->right, i - lc - 1, std::move(text)));
+         return make_node(std::move(text), t->left, t->right, t->priority);
+      }
+
+      // Build a balanced tree from [first, last). Each node takes the
+      // highest priority of its subtree, so the heap order holds.
+      node_ptr build(paragraph_ptr const* first, paragraph_ptr const* last)
+      {
+         if (first == last)
+            return {};
+         auto mid = first + (last - first) / 2;
+         auto left = build(first, mid);
+         auto right = build(mid + 1, last);
+         auto priority = new_priority();
+         if (left)
+            priority = std::max(priority, left->priority);
+         if (right)
+            priority = std::max(priority, right->priority);
+         return make_node(*mid, std::move(left), std::move(right), priority);
+      }
+
+      // Call f on every paragraph from index i on, in order, until f
+      // returns false. Returns false if f did.
+      template <typename F>
+      bool visit(node_ptr const& t, std::size_t i, F& f)
+      {
+         if (!t)
+            return true;
+         auto lc = count_of(t->left);
+         if (i < lc && !visit(t->left, i, f))
+            return false;
+         if (i <= lc && !f(*t->text))
+            return false;
+         return visit(t->right, i > lc? i - lc - 1 : 0, f);
+      }
+
+      // The number of leading (or trailing, if !forward) paragraphs that a
+      // and b share. We walk both trees in order, but skip the subtrees
+      // they share whole, so when b is an edited copy of a this costs
+      // about the length of the paths the edits copied.
+      std::size_t common(node_ptr const& a, node_ptr const& b, bool forward)
+      {
+         // A subtree, or the paragraph of a node alone
+         struct item
+         {
+            node const*       n;
+            bool              self;
+
+            std::size_t       count() const { return self? 1 : n->count; }
+         };
+
+         // The front of each sequence is at the back of its stack
+         auto expand = [forward](std::vector<item>& stack)
+         {
+            auto n = stack.back().n;
+            stack.pop_back();
+            auto& near = forward? n->left : n->right;
+            auto& far = forward? n->right : n->left;
+            if (far)
+               stack.push_back({ far.get(), false });
+            stack.push_back({ n, true });
+            if (near)
+               stack.push_back({ near.get(), false });
+         };
+
+         std::vector<item> sa, sb;
+         if (a)
+            sa.push_back({ a.get(), false });
+         if (b)
+            sb.push_back({ b.get(), false });
+
+         std::size_t n = 0;
+         while (!sa.empty() && !sb.empty())
+         {
+            auto x = sa.back();
+            auto y = sb.back();
+            if (x.self && y.self)
+            {
+               if (x.n->text != y.n->text)
+                  break;
+               ++n;
+               sa.pop_back();
+               sb.pop_back();
+            }
+            else if (!x.self && !y.self && x.n == y.n)
+            {
+               n += x.n->count;
+               sa.pop_back();
+               sb.pop_back();
+            }
+            else
+            {
+               // Break up the larger subtree (both, if the same size) and
+               // compare again
+               auto cx = x.count();
+               auto cy = y.count();
+               if (!x.self && cx >= cy)
+                  expand(sa);
+               if (!y.self && cy >= cx)
+                  expand(sb);
+            }
+         }
+         return n;
+      }
+
+      // Split [first, last) into paragraphs, each one ending with its
+      // newline. The remainder after the last newline is added only if
+      // it is not empty or if keep_tail is true.
+      void split(
+         char const* first, char const* last
+       , paragraph_list& out, bool keep_tail
+      )
+      {
+         while (first != last)
+         {
+            auto nl = std::find(first, last, '\n');
+            if (nl == last)
+               break;
+            out.push_back(std::make_shared<std::string>(first, nl + 1));
+            first = nl + 1;
+         }
+         if (first != last || keep_tail)
+            out.push_back(std::make_shared<std::string>(first, last));
+      }
+
+      node_ptr build(paragraph_list const& list)
+      {
+         return build(list.data(), list.data() + list.size());
+      }
+   }
+
+   namespace detail
+   {
+      paragraph_node::paragraph_node(
+         paragraph_ptr text_, node_ptr left_, node_ptr right_
+       , std::uint32_t priority_
+      )
+       : text(std::move(text_))
+       , left(std::move(left_))
+       , right(std::move(right_))
+       , size(size_of(left) + text->size() + size_of(right))
+       , count(count_of(left) + 1 + count_of(right))
+       , priority(priority_)
+      {}
+   }
+
+   text_buffer::text_buffer(std::string const& text)
+   {
+      assign(text);
+   }
+
+   text_buffer::text_buffer(text_buffer const& rhs)
+    : _root(rhs._root)
+    , _size(rhs._size)
+    , _revision(rhs._revision)
+    , _damage(rhs._damage)
+   {}
+
+   text_buffer& text_buffer::operator=(text_buffer const& rhs)
+   {
+      if (&rhs != this)
+      {
+         // Typically, rhs is an older copy of this buffer (e.g. an undo
+         // state) sharing most of our paragraphs. Only the ones in
+         // between the common head and tail changed.
+         auto n = std::min(paragraphs(), rhs.paragraphs());
+         auto head = common(_root, rhs._root, true);
+         auto tail = std::min(common(_root, rhs._root, false), n - head);
+
+         _root = rhs._root;
+         _size = rhs._size;
+         changed(head, tail);
+      }
+      return *this;
+   }
+
+   std::string const& text_buffer::str() const
+   {
+      if (!_flat_valid)
+      {
+         _flat.clear();
+         _flat.reserve(_size);
+         auto append = [this](std::string const& p) { _flat += p; return true; };
+         visit(_root, 0, append);
+         _flat_valid = true;
+      }
+      return _flat;
+   }
+
+   std::string text_buffer::substr(std::size_t pos, std::size_t n) const
+   {
+      std::string result;
+      pos = std::min(pos, _size);
+      n = std::min(n, _size - pos);
+      result.reserve(n);
+
+      auto loc = locate(pos);
+      auto offset = pos - loc.start;
+      auto append =
+         [&](std::string const& p)
+         {
+            auto count = std::min(n, p.size() - offset);
+            result.append(p, offset, count);
+            n -= count;
+            offset = 0;
+            return n != 0;
+         };
+      if (n)
+         visit(_root, loc.index, append);
+      return result;
+   }
+
+   void text_buffer::assign(std::string const& text)
+   {
+      paragraph_list list;
+      split(text.data(), text.data() + text.size(), list, true);
+      _root = build(list);
+      _size = text.size();
+      changed(0, 0);
+   }
+
+   void text_buffer::insert(std::size_t pos, std::string const& s)
+   {
+      splice(pos, 0, s.data(), s.data() + s.size());
+   }
+
+   void text_buffer::erase(std::size_t pos, std::size_t n)
+   {
+      splice(pos, n, nullptr, nullptr);
+   }
+
+   void text_buffer::replace(std::size_t pos, std::size_t n, std::string const& s)
+   {
+      splice(pos, n, s.data(), s.data() + s.size());
+   }
+
+   std::size_t text_buffer::paragraphs() const
+   {
+      return count_of(_root);
+   }
+
+   text_buffer::paragraph_ptr const& text_buffer::share(std::size_t i) const
+   {
+      auto t = _root.get();
+      while (true)
+      {
+         auto lc = count_of(t->left);
+         if (i < lc)
+         {
+            t = t->left.get();
+         }
+         else if (i > lc)
+         {
+            i -= lc + 1;
+            t = t->right.get();
+         }
+         else
+         {
+            return t->text;
+         }
+      }
+   }
+
+   std::size_t text_buffer::paragraph_start(std::size_t i) const
+   {
+      std::size_t start = 0;
+      for (auto t = _root.get(); t;)
+      {
+         auto lc = count_of(t->left);
+         if (i <= lc)
+         {
+            t = t->left.get();
+         }
+         else
+         {
+            start += size_of(t->left) + t->text->size();
+            i -= lc + 1;
+            t = t->right.get();
+         }
+      }
+      return start;
+   }
+
+   std::size_t text_buffer::find_paragraph(std::size_t pos) const
+   {
+      return locate(pos).index;
+   }
+
+   text_buffer::location text_buffer::locate(std::size_t pos) const
+   {
+      // Find the last paragraph that starts at or before pos
+      location loc = { nullptr, 0, 0 };
+      std::size_t index = 0;
+      std::size_t start = 0;
+      for (auto t = _root.get(); t;)
+      {
+         auto node_start = start + size_of(t->left);
+         auto node_index = index + count_of(t->left);
+         if (node_start <= pos)
+         {
+            loc = { t, node_index, node_start };
+            start = node_start + t->text->size();
+            index = node_index + 1;
+            t = t->right.get();
+         }
+         else
+         {
+            t = t->left.get();
+         }
+      }
+      return loc;
+   }
+
+   void text_buffer::clean()
+   {
+      _damage = { std::size_t(-1), std::size_t(-1) };
+   }
+
+   char const* text_buffer::at(std::size_t pos) const
+   {
+      auto loc = locate(pos);
+      return loc.at->text->data() + (pos - loc.start);
+   }
+
+   unsigned text_buffer::codepoint(std::size_t pos) const
+   {
+      char const* p = at(pos);
+      return elements::codepoint(p);
+   }
+
+   std::size_t text_buffer::next(std::size_t pos) const
+   {
+      if (pos >= _size)
+         return _size;
+
+      auto loc = locate(pos);
+      auto const& p = *loc.at->text;
+      auto first = p.data();
+      return loc.start + (next_utf8(first + p.size(), first + (pos - loc.start)) - first);
+   }
+
+   std::size_t text_buffer::prev(std::size_t pos) const
+   {
+      if (pos == 0)
+         return 0;
+
+      auto loc = locate(pos);
+
+      // At the start of a paragraph: step back over the previous
+      // paragraph's newline.
+      if (pos == loc.start)
+         return pos - 1;
+
+      auto first = loc.at->text->data();
+      return loc.start + (prev_utf8(first, first + (pos - loc.start)) - first);
+   }
+
+   void text_buffer::splice(
+      std::size_t pos, std::size_t n
+    , char const* first, char const* last
+   )
+   {
+      pos = std::min(pos, _size);
+      n = std::min(n, _size - pos);
+
+      auto loc1 = locate(pos);
+      auto loc2 = locate(pos + n);
+      auto i1 = loc1.index;
+      auto i2 = loc2.index;
+      auto offset1 = pos - loc1.start;
+      auto offset2 = (pos + n) - loc2.start;
+      auto const& p1 = *loc1.at->text;
+      auto const& p2 = *loc2.at->text;
+      auto inserted = std::size_t(last - first);
+      auto tail = paragraphs() - i2 - 1;
+
+      if (i1 == i2 && std::find(first, last, '\n') == last)
+      {
+         // The common case: no newlines added or removed. Only one
+         // paragraph changes.
+         auto p = std::make_shared<std::string>();
+         p->reserve(p1.size() - n + inserted);
+         p->append(p1, 0, offset1);
+         p->append(first, last);
+         p->append(p1, offset2, std::string::npos);
+         _root = elements::replace(_root, i1, std::move(p));
+      }
+      else
+      {
+         std::string joined;
+         joined.reserve(offset1 + inserted + (p2.size() - offset2));
+         joined.append(p1, 0, offset1);
+         joined.append(first, last);
+         joined.append(p2, offset2, std::string::npos);
+
+         paragraph_list replacement;
+         bool is_last = tail == 0;
+         split(joined.data(), joined.data() + joined.size(), replacement, is_last);
+
+         // Cut out paragraphs i1 to i2 and put the replacement in between
+         auto head_rest = elements::split(_root, i1);
+         auto mid_tail = elements::split(head_rest.second, i2 - i1 + 1);
+         _root = merge(merge(head_rest.first, build(replacement)), mid_tail.second);
+      }
+
+      _size = _size - n + inserted;
+      changed(i1, tail);
+   }
+
+   void text_buffer::changed(std::size_t head, std::size_t tail)
+   {
+      _damage.head = std::min(_damage.head, head);
+      _damage.tail = std::min(_damage.tail, tail);
+      _flat_valid = false;
+      ++_revision;
+   }
+}}
@@ -5,12 +5,19 @@
 =============================================================================*/
 #include <elements/support/theme.hpp>
 #include <elements/view.hpp>
+#include <atomic>
 
 namespace cycfi { namespace elements
 {
    // The global theme
    theme _theme;
 
+   namespace
+   {
+      // Generation 0 is never current (see theme_generation)
+      std::atomic<std::size_t> _theme_generation{ 1 };
+   }
+
    theme const& get_theme()
    {
       return _theme;
@@ -19,5 +26,14 @@ namespace cycfi { namespace elements
    void set_theme(theme const& thm)
    {
       _theme = thm;
+
+      // Fonts and sizes may have changed
+      relimit_all();
+      _theme_generation.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   std::size_t theme_generation()
+   {
+      return _theme_generation.load(std::memory_order_relaxed);
    }
 }}
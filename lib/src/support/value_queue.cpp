@@ -0,0 +1,70 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/value_queue.hpp>
+
+namespace cycfi { namespace elements
+{
+   namespace
+   {
+      std::size_t round_up_pow2(std::size_t n)
+      {
+         std::size_t r = 2;
+         while (r < n)
+            r *= 2;
+         return r;
+      }
+   }
+
+   value_queue::value_queue(std::size_t capacity)
+    : _cells(new cell[round_up_pow2(capacity)])
+    , _mask(round_up_pow2(capacity) - 1)
+   {
+      for (std::size_t i = 0; i <= _mask; ++i)
+         _cells[i].seq.store(i, std::memory_order_relaxed);
+   }
+
+   bool value_queue::push(entry const& e)
+   {
+      cell* c;
+      auto pos = _tail.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         c = &_cells[pos & _mask];
+         auto seq = c->seq.load(std::memory_order_acquire);
+         auto diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+         if (diff == 0)
+         {
+            // The cell is free. Claim it, unless another producer beat us.
+            if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               break;
+         }
+         else if (diff < 0)
+         {
+            return false; // Full
+         }
+         else
+         {
+            pos = _tail.load(std::memory_order_relaxed);
+         }
+      }
+      c->data = e;
+      c->seq.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   bool value_queue::pop(entry& e)
+   {
+      cell* c = &_cells[_head & _mask];
+      auto seq = c->seq.load(std::memory_order_acquire);
+      if (std::ptrdiff_t(seq) - std::ptrdiff_t(_head + 1) < 0)
+         return false; // Empty
+
+      e = c->data;
+      c->seq.store(_head + _mask + 1, std::memory_order_release);
+      ++_head;
+      return true;
+   }
+}}
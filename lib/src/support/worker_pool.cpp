@@ -0,0 +1,80 @@
+/*=============================================================================
+   Copyright (c) 2016-2019 Joel de Guzman
+
+   Distributed under the MIT License [ https://opensource.org/licenses/MIT ]
+=============================================================================*/
+#include <elements/support/worker_pool.hpp>
+
+namespace cycfi { namespace elements
+{
+   worker_pool::~worker_pool()
+   {
+      stop();
+   }
+
+   void worker_pool::workers(std::size_t n)
+   {
+      if (n == _threads.size())
+         return;
+
+      stop();
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stop = false;
+
+      // Each worker starts from the current epoch, so it waits for the
+      // next task, not the last one.
+      for (std::size_t i = 0; i != n; ++i)
+         _threads.emplace_back([this, epoch = _epoch]() { work(epoch); });
+   }
+
+   void worker_pool::run(task const& f)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _task = &f;
+         _busy = _threads.size();
+         ++_epoch;
+      }
+      _start.notify_all();
+
+      f();
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this]() { return _busy == 0; });
+      _task = nullptr;
+   }
+
+   void worker_pool::stop()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _start.notify_all();
+      for (auto& t : _threads)
+         t.join();
+      _threads.clear();
+   }
+
+   void worker_pool::work(std::size_t epoch)
+   {
+      for (;;)
+      {
+         task const* f = nullptr;
+         {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start.wait(lock, [&]() { return _stop || _epoch != epoch; });
+            if (_stop)
+               return;
+            epoch = _epoch;
+            f = _task;
+         }
+
+         (*f)();
+
+         std::lock_guard<std::mutex> lock(_mutex);
+         if (--_busy == 0)
+            _done.notify_one();
+      }
+   }
+}}
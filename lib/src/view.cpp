@@ -6,16 +6,55 @@
 #include <elements/view.hpp>
 #include <elements/window.hpp>
 #include <elements/support/context.hpp>
+#include <elements/element/cache.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
 
  namespace cycfi { namespace elements
  {
+   namespace
+   {
+      // Scratch context for calls made off the UI thread, one per thread
+      struct thread_scratch
+      {
+         detail::scratch_context scratch;
+         canvas               cnv{ *scratch.context() };
+      };
+
+      canvas& thread_canvas()
+      {
+         static thread_local thread_scratch local;
+         return local.cnv;
+      }
+
+      // The tile the current thread is drawing, if any (see draw_tiled)
+      struct tile_damage
+      {
+         view const*          owner = nullptr;
+         region               dirty;
+      };
+
+      thread_local tile_damage current_tile;
+   }
+
+   region const& view::dirty() const
+   {
+      return current_tile.owner == this? current_tile.dirty : _dirty;
+   }
+
    view::view(host_view h)
     : base_view(h)
+    , _scratch_canvas(*_scratch.context())
+    , _ui_thread(std::this_thread::get_id())
     , _work(_io)
    {}
 
    view::view(window& win)
     : base_view(win.host())
+    , _scratch_canvas(*_scratch.context())
+    , _ui_thread(std::this_thread::get_id())
     , _work(_io)
    {
       on_change_limits = [&win](view_limits limits_)
@@ -34,14 +73,13 @@
       if (_content.empty())
          return false;
 
-      auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-      auto context_ = cairo_create(surface_);
-      canvas cnv{ *context_ };
+      auto state = _scratch_canvas.new_state();
       bool resized = false;
 
       // Update the limits and constrain the window size to the limits
-      basic_context bctx{ *this, cnv };
+      basic_context bctx{ *this, _scratch_canvas };
       auto limits_ = _content.limits(bctx);
+      count_limits();
       if (limits_.min != _current_limits.min || limits_.max != _current_limits.max)
       {
          resized = true;
@@ -50,8 +88,6 @@
             on_change_limits(limits_);
       }
 
-      cairo_surface_destroy(surface_);
-      cairo_destroy(context_);
       return resized;
    }
 
@@ -60,12 +96,60 @@
       if (_content.empty())
          return;
 
-      _dirty = dirty_;
+      // The host hands us the bounding rect of everything invalidated, and
+      // clips the context to the actual damage. The damage is our own list,
+      // plus any rect of the host's clip that none of our rects covers
+      // (give or take a pixel of rounding). Those are damage the host
+      // added of its own (e.g. an expose).
+      if (!_drawn_all && !_drawn_damage.empty())
+      {
+         _dirty.clear();
+         for (auto r : _drawn_damage)
+            _dirty.add(clip(r.inset(-1, -1), dirty_));
+
+         auto clip_rects = cairo_copy_clip_rectangle_list(context_);
+         if (clip_rects->status == CAIRO_STATUS_SUCCESS)
+         {
+            for (int i = 0; i != clip_rects->num_rectangles; ++i)
+            {
+               auto const& cr = clip_rects->rectangles[i];
+               rect r = { float(cr.x), float(cr.y)
+                  , float(cr.x + cr.width), float(cr.y + cr.height) };
+               bool covered = std::any_of(_drawn_damage.begin(), _drawn_damage.end(),
+                  [r](rect ours) { return ours.inset(-1, -1).includes(r); });
+               if (!covered)
+                  _dirty.add(clip(r, dirty_));
+            }
+         }
+         else
+         {
+            _dirty = dirty_;
+         }
+         cairo_rectangle_list_destroy(clip_rects);
+      }
+      else
+      {
+         _dirty = dirty_;
+      }
+      _drawn_damage.clear();
+      _drawn_all = false;
+
+      invalidate_caches();
+
+      if (_profiler)
+         _profiler->begin_frame();
+
+      for (auto const& r : _dirty)
+         _frame_stats.dirty_area += area(r);
 
       // Update the limits and constrain the window size to the limits
-      if (set_limits())
+      auto start = clock::now();
+      bool resized = set_limits();
+      _frame_stats.limits_time = clock::now() - start;
+      if (resized)
       {
          refresh();
+         end_frame();
          return;
       }
 
@@ -74,75 +158,317 @@
       rect subj_bounds = { 0, 0, size_.x, size_.y };
       context ctx{ *this, cnv, &_content, subj_bounds };
 
-      // layout the subject only if the window bounds changes
-      if (_relayout || subj_bounds != _current_bounds)
+      // layout the subject only if the window bounds changes or if some
+      // element asked for a relayout. The content lays out only the
+      // elements that moved or are marked dirty.
+      start = clock::now();
+      if (subj_bounds != _current_bounds || _content.needs_layout(ctx))
       {
-         _relayout = false;
          _current_bounds = subj_bounds;
+         _content.layout_dirty(false);
          _content.layout(ctx);
       }
+      _frame_stats.layout_time = clock::now() - start;
 
       // draw the subject
-      _content.draw(ctx);
+      start = clock::now();
+      if (_draw_threads > 1
+         && area(_dirty.bounds()) >= parallel_draw_min_area
+         && _content.concurrent_draw())
+         draw_tiled(context_, subj_bounds);
+      else
+      {
+         draw_profiler::scope scope{ _profiler, _content, subj_bounds };
+         _content.draw(ctx);
+      }
+      _frame_stats.draw_time = clock::now() - start;
+
+      end_frame();
    }
 
-   namespace
+   void view::end_frame()
    {
-      template <typename F, typename This>
-      void call(F f, This& self, rect _current_bounds)
+      _frame_stats.limits_calls = _limits_calls.exchange(0, std::memory_order_relaxed);
+      _frame_stats.draw_calls = _draw_calls.exchange(0, std::memory_order_relaxed);
+      _frame_stats.culled = _culled.exchange(0, std::memory_order_relaxed);
+
+      _stats = _frame_stats;
+      _frame_stats = frame_stats{};
+      if (on_stats)
+         on_stats(_stats);
+   }
+
+   void view::draw_tiled(cairo_t* context_, rect subj_bounds)
+   {
+      // Split the damage into cells of a fixed grid. Cells are disjoint
+      // and their edges fall on whole pixels, so antialiasing matches
+      // across the seams.
+      auto const  size = parallel_draw_tile_size;
+      auto const  damage = _dirty.bounds();
+      std::vector<rect> tiles;
+      for (float y = std::floor(damage.top / size) * size; y < damage.bottom; y += size)
       {
-         auto surface_ = cairo_recording_surface_create(CAIRO_CONTENT_COLOR_ALPHA, nullptr);
-         auto context_ = cairo_create(surface_);
-         canvas cnv{ *context_ };
-         context ctx { self, cnv, &self.content(), _current_bounds };
+         for (float x = std::floor(damage.left / size) * size; x < damage.right; x += size)
+         {
+            rect tile = clip({ x, y, x + size, y + size }, damage);
+            tile = {
+               std::floor(tile.left), std::floor(tile.top)
+             , std::ceil(tile.right), std::ceil(tile.bottom)
+            };
+            if (!tile.is_empty() && intersects(tile, _dirty))
+               tiles.push_back(tile);
+         }
+      }
 
-         f(ctx, self.content());
+      // Tiles are rendered at the device scale of the target surface
+      double scale_x = 1, scale_y = 1;
+      cairo_surface_get_device_scale(cairo_get_target(context_), &scale_x, &scale_y);
 
-         cairo_surface_destroy(surface_);
-         cairo_destroy(context_);
+      std::vector<cairo_surface_t*> surfaces(tiles.size(), nullptr);
+      auto draw_tile =
+         [&](std::size_t i)
+         {
+            auto const& tile = tiles[i];
+            auto surface = cairo_image_surface_create(
+               CAIRO_FORMAT_ARGB32
+             , std::ceil(tile.width() * scale_x)
+             , std::ceil(tile.height() * scale_y)
+            );
+            cairo_surface_set_device_scale(surface, scale_x, scale_y);
+            cairo_surface_set_device_offset(surface, -tile.left * scale_x, -tile.top * scale_y);
+
+            auto cr = cairo_create(surface);
+            cairo_rectangle(cr, tile.left, tile.top, tile.width(), tile.height());
+            cairo_clip(cr);
+            {
+               // Elements cull against dirty(), so each tile walks and
+               // draws only what is damaged within it.
+               current_tile.owner = this;
+               current_tile.dirty = clip(_dirty, tile);
+
+               canvas cnv{ *cr };
+               context ctx{ *this, cnv, &_content, subj_bounds };
+               draw_profiler::scope scope{ _profiler, _content, subj_bounds };
+               _content.draw(ctx);
+
+               current_tile.owner = nullptr;
+            }
+            cairo_destroy(cr);
+            cairo_surface_flush(surface);
+            surfaces[i] = surface;
+         };
+
+      // Workers pull tiles off a shared counter. The UI thread lends a hand.
+      std::atomic<std::size_t> next{ 0 };
+      worker_pool::task worker =
+         [&]()
+         {
+            for (std::size_t i; (i = next++) < tiles.size();)
+               draw_tile(i);
+         };
+
+      // The limits were all measured on this thread by set_limits and
+      // layout. From here on, they are only read (see drawing_tiles).
+      _draw_pool.workers(_draw_threads - 1);
+      _drawing_tiles = true;
+      _draw_pool.run(worker);
+      _drawing_tiles = false;
+
+      // Composite the tiles. The tile surfaces carry their own device scale
+      // and offset, so they land where they belong in user space.
+      for (std::size_t i = 0; i != tiles.size(); ++i)
+      {
+         auto const& tile = tiles[i];
+         cairo_save(context_);
+         cairo_set_source_surface(context_, surfaces[i], 0, 0);
+         cairo_rectangle(context_, tile.left, tile.top, tile.width(), tile.height());
+         cairo_fill(context_);
+         cairo_restore(context_);
+         cairo_surface_destroy(surfaces[i]);
       }
    }
 
+   template <typename F>
+   void view::call(F f)
+   {
+      // The scratch canvas state is saved here and restored on exit, so
+      // every call starts with a clean context. Calls may nest (e.g. an
+      // element refreshing another element while handling an event).
+      // The shared scratch canvas is for the UI thread only.
+      auto& cnv = std::this_thread::get_id() == _ui_thread?
+         _scratch_canvas : thread_canvas();
+
+      auto state = cnv.new_state();
+      cairo_new_path(&cnv.cairo_context());
+
+      context ctx { *this, cnv, &_content, _current_bounds };
+      f(ctx, _content);
+   }
+
    void view::refresh()
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this]()
-         {
-            base_view::refresh();
-         }
-      );
+      // Allow refresh to be called from another thread. Only the first
+      // request since the last flush posts a flush.
+      bool post_flush = false;
+      {
+         std::lock_guard<std::mutex> lock(_damage_mutex);
+         post_flush = !_damage_all && _damage.empty();
+         _damage_all = true;
+         _damage.clear();
+      }
+      if (post_flush)
+         _io.post([this]() { flush_damage(); });
    }
 
    void view::refresh(rect area)
    {
-      // Allow refresh to be called from another thread
-      _io.post(
-         [this, area]()
-         {
-            base_view::refresh(area);
-         }
-      );
+      if (area.is_empty() || !is_valid(area))
+         return;
+
+      // Allow refresh to be called from another thread. Only the first
+      // request since the last flush posts a flush.
+      bool post_flush = false;
+      {
+         std::lock_guard<std::mutex> lock(_damage_mutex);
+         if (_damage_all)
+            return;
+         post_flush = _damage.empty();
+         _damage.add(area);
+      }
+      if (post_flush)
+         _io.post([this]() { flush_damage(); });
+   }
+
+   void view::flush_damage()
+   {
+      region damage;
+      bool all = false;
+      {
+         std::lock_guard<std::mutex> lock(_damage_mutex);
+         std::swap(damage, _damage);
+         std::swap(all, _damage_all);
+      }
+
+      if (all)
+      {
+         _drawn_all = true;
+         base_view::refresh();
+      }
+      else
+      {
+         _drawn_damage.add(damage);
+         for (auto const& r : damage)
+            base_view::refresh(r);
+      }
+   }
+
+   bool view::find_bounds(element const& e, rect& bounds)
+   {
+      std::lock_guard<std::mutex> lock(_bounds_mutex);
+      auto generation = limits_generation();
+      if (_bounds_generation != generation)
+      {
+         _bounds_index.clear();
+         _stale_caches.clear();
+         _bounds_generation = generation;
+         return false;
+      }
+
+      auto i = _bounds_index.find(&e);
+      if (i == _bounds_index.end())
+         return false;
+      bounds = i->second.bounds;
+      for (auto c : i->second.caches)
+      {
+         if (std::find(_stale_caches.begin(), _stale_caches.end(), c) == _stale_caches.end())
+            _stale_caches.push_back(c);
+      }
+      return true;
+   }
+
+   void view::clear_bounds()
+   {
+      std::lock_guard<std::mutex> lock(_bounds_mutex);
+      _bounds_index.clear();
+      _stale_caches.clear();
+   }
+
+   void view::invalidate_caches()
+   {
+      std::lock_guard<std::mutex> lock(_bounds_mutex);
+
+      // The caches may be gone if the tree changed since they were listed
+      if (_bounds_generation == limits_generation())
+      {
+         for (auto c : _stale_caches)
+            c->invalidate();
+      }
+      _stale_caches.clear();
+   }
+
+   void view::update_bounds(element const& e, rect bounds)
+   {
+      std::lock_guard<std::mutex> lock(_bounds_mutex);
+      auto i = _bounds_index.find(&e);
+      if (i != _bounds_index.end())
+         i->second.bounds = bounds;
    }
 
    void view::refresh(element& element)
    {
-      if (_current_bounds.is_empty())
+      bool ui_thread = std::this_thread::get_id() == _ui_thread;
+      if (ui_thread && _current_bounds.is_empty())
+         return;
+
+      rect bounds;
+      if (find_bounds(element, bounds))
+      {
+         refresh(bounds);
+         return;
+      }
+
+      // Not indexed yet. Only the UI thread may walk the tree, so other
+      // threads hand the request over.
+      if (!ui_thread)
+      {
+         _io.post([this, &element]() { refresh(element); });
          return;
+      }
 
+      // Find the element the slow way. refresh(ctx) adds it to the index
+      // when it is found.
+      _refresh_target = &element;
       call(
-         [&element](auto const& ctx, auto& _content) { _content.refresh(ctx, element); },
-         *this, _current_bounds
+         [&element](auto const& ctx, auto& _content) { _content.refresh(ctx, element); }
       );
+      _refresh_target = nullptr;
    }
 
    void view::refresh(context const& ctx)
    {
+      if (_refresh_target && ctx.element == _refresh_target)
+      {
+         cache_list caches;
+         for (auto p = ctx.parent; p; p = p->parent)
+         {
+            if (auto c = dynamic_cast<cache_element*>(p->element))
+            {
+               c->invalidate();
+               caches.push_back(c);
+            }
+         }
+
+         std::lock_guard<std::mutex> lock(_bounds_mutex);
+         _bounds_index[_refresh_target] = { ctx.bounds, std::move(caches) };
+      }
       refresh(ctx.bounds);
    }
 
    void view::click(mouse_button btn)
    {
+      if (_recorder)
+         _recorder->record_click(btn);
+
       _current_button = btn;
       if (_content.empty())
          return;
@@ -152,25 +478,29 @@
          {
             _content.click(ctx, btn);
             _is_focus = _content.focus();
-         },
-         *this, _current_bounds
+         }
       );
    }
 
    void view::drag(mouse_button btn)
    {
+      if (_recorder)
+         _recorder->record_drag(btn);
+
       _current_button = btn;
       if (_content.empty())
          return;
 
       call(
-         [btn](auto const& ctx, auto& _content) { _content.drag(ctx, btn); },
-         *this, _current_bounds
+         [btn](auto const& ctx, auto& _content) { _content.drag(ctx, btn); }
       );
    }
 
    void view::cursor(point p, cursor_tracking status)
    {
+      if (_recorder)
+         _recorder->record_cursor(p, status);
+
       if (_content.empty())
          return;
 
@@ -179,41 +509,46 @@
          {
             if (!_content.cursor(ctx, p, status))
                set_cursor(cursor_type::arrow);
-         },
-         *this, _current_bounds
+         }
       );
    }
 
    void view::scroll(point dir, point p)
    {
+      if (_recorder)
+         _recorder->record_scroll(dir, p);
+
       if (_content.empty())
          return;
 
       call(
-         [dir, p](auto const& ctx, auto& _content) { _content.scroll(ctx, dir, p); },
-         *this, _current_bounds
+         [dir, p](auto const& ctx, auto& _content) { _content.scroll(ctx, dir, p); }
       );
    }
 
    void view::key(key_info const& k)
    {
+      if (_recorder)
+         _recorder->record_key(k);
+
       if (_content.empty())
          return;
 
       call(
-         [k](auto const& ctx, auto& _content) { _content.key(ctx, k); },
-         *this, _current_bounds
+         [k](auto const& ctx, auto& _content) { _content.key(ctx, k); }
       );
    }
 
    void view::text(text_info const& info)
    {
+      if (_recorder)
+         _recorder->record_text(info);
+
       if (_content.empty())
          return;
 
       call(
-         [info](auto const& ctx, auto& _content) { _content.text(ctx, info); },
-         *this, _current_bounds
+         [info](auto const& ctx, auto& _content) { _content.text(ctx, info); }
       );
    }
 
@@ -266,11 +601,127 @@
    void view::content(layers_type&& layers)
    {
       _content = std::forward<layers_type>(layers);
+      _content.invalidate_limits();
+      clear_bounds();
+      _content.layout_dirty(true);
       set_limits();
    }
 
+   void view::apply_values()
+   {
+      // Coalesce the queued values, keeping the latest per element
+      value_queue::entry e;
+      while (_values.pop(e))
+         _latest_values[e.element] = e;
+
+      for (auto const& item : _latest_values)
+      {
+         auto& latest = item.second;
+         auto& el = *latest.element;
+         switch (latest.kind)
+         {
+            case value_queue::entry::bool_:     el.value(latest.value != 0); break;
+            case value_queue::entry::int_:      el.value(int(latest.value)); break;
+            case value_queue::entry::double_:   el.value(latest.value); break;
+         }
+         refresh(el);
+      }
+      _latest_values.clear();
+   }
+
+   void view::add_binding(
+      element& e, value_queue::entry::kind_type kind
+    , std::function<double()> load, double epsilon
+   )
+   {
+      unbind(e);
+      _bindings.push_back({ &e, kind, std::move(load), epsilon, 0, false });
+   }
+
+   void view::bind(element& e, std::atomic<double> const& src, double epsilon)
+   {
+      add_binding(
+         e, value_queue::entry::double_
+       , [&src]() { return src.load(std::memory_order_relaxed); }
+       , epsilon
+      );
+   }
+
+   void view::bind(element& e, std::atomic<float> const& src, double epsilon)
+   {
+      add_binding(
+         e, value_queue::entry::double_
+       , [&src]() { return double(src.load(std::memory_order_relaxed)); }
+       , epsilon
+      );
+   }
+
+   void view::bind(element& e, std::atomic<int> const& src)
+   {
+      add_binding(
+         e, value_queue::entry::int_
+       , [&src]() { return double(src.load(std::memory_order_relaxed)); }
+       , 0
+      );
+   }
+
+   void view::bind(element& e, std::atomic<bool> const& src)
+   {
+      add_binding(
+         e, value_queue::entry::bool_
+       , [&src]() { return double(src.load(std::memory_order_relaxed)); }
+       , 0
+      );
+   }
+
+   void view::unbind(element& e)
+   {
+      _bindings.erase(
+         std::remove_if(_bindings.begin(), _bindings.end(),
+            [&e](auto const& b) { return b.element == &e; })
+       , _bindings.end()
+      );
+   }
+
+   void view::poll_bindings()
+   {
+      for (auto& b : _bindings)
+      {
+         double val = b.load();
+         if (b.applied && std::abs(val - b.last) <= b.epsilon)
+            continue;
+
+         b.last = val;
+         b.applied = true;
+         switch (b.kind)
+         {
+            case value_queue::entry::bool_:     b.element->value(val != 0); break;
+            case value_queue::entry::int_:      b.element->value(int(val)); break;
+            case value_queue::entry::double_:   b.element->value(val); break;
+         }
+         refresh(*b.element);
+      }
+   }
+
    void view::poll()
    {
+      // Hosts call poll once per frame. Keep a running average of the time
+      // between frames. Long gaps (e.g. the host stopped ticking while the
+      // window was hidden) are not frames, so we skip those.
+      auto now = clock::now();
+      if (_last_frame != clock::time_point{})
+      {
+         duration elapsed = now - _last_frame;
+         if (elapsed < _frame_budget * 4)
+            _frame_budget = (_frame_budget * 7 + elapsed) / 8;
+      }
+      _last_frame = now;
+
+      apply_values();
+      poll_bindings();
+      if (on_frame)
+         on_frame(*this);
       _io.poll();
+      _frame_stats.io_time += clock::now() - now;
    }
 }}